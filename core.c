@@ -23,6 +23,22 @@ static bool rtw89_disable_ps_mode;
 module_param_named(disable_ps_mode, rtw89_disable_ps_mode, bool, 0644);
 MODULE_PARM_DESC(disable_ps_mode, "Set Y to disable low power mode");
 
+static unsigned int rtw89_tx_kick_thold = 32;
+module_param_named(tx_kick_thold, rtw89_tx_kick_thold, uint, 0644);
+MODULE_PARM_DESC(tx_kick_thold, "Kick a TX ring once this number of frames is written in a scheduling round (0: kick per TXQ)");
+
+static bool rtw89_disable_tx_desc_tmpl;
+module_param_named(disable_tx_desc_tmpl, rtw89_disable_tx_desc_tmpl, bool, 0644);
+MODULE_PARM_DESC(disable_tx_desc_tmpl, "Set Y to build TX descriptor of data frames from scratch for every frame");
+
+static bool rtw89_ppdu_sts_immediate;
+module_param_named(ppdu_sts_immediate, rtw89_ppdu_sts_immediate, bool, 0644);
+MODULE_PARM_DESC(ppdu_sts_immediate, "Set Y to deliver RX frames without waiting for PPDU status (signal comes from station average, beacons still wait to keep beacon RSSI offload)");
+
+static unsigned int rtw89_airtime_inflight_us = 8000;
+module_param_named(airtime_inflight_us, rtw89_airtime_inflight_us, uint, 0644);
+MODULE_PARM_DESC(airtime_inflight_us, "Cap of estimated airtime in us a station can have queued in hardware per AC (0: no cap)");
+
 #define RTW89_DEF_CHAN(_freq, _hw_val, _flags, _band)	\
 	{ .center_freq = _freq, .hw_value = _hw_val, .flags = _flags, .band = _band, }
 #define RTW89_DEF_CHAN_2G(_freq, _hw_val)	\
@@ -234,6 +250,9 @@ static void rtw89_traffic_stats_accu(struct rtw89_dev *rtwdev,
 {
 	struct ieee80211_hdr *hdr = (struct ieee80211_hdr *)skb->data;
 
+	if (unlikely(!stats->pcpu))
+		return;
+
 	if (!ieee80211_is_data(hdr->frame_control))
 		return;
 
@@ -242,14 +261,50 @@ static void rtw89_traffic_stats_accu(struct rtw89_dev *rtwdev,
 		return;
 
 	if (tx) {
-		stats->tx_cnt++;
-		stats->tx_unicast += skb->len;
+		this_cpu_inc(stats->pcpu->tx_cnt);
+		this_cpu_add(stats->pcpu->tx_unicast, skb->len);
 	} else {
-		stats->rx_cnt++;
-		stats->rx_unicast += skb->len;
+		this_cpu_inc(stats->pcpu->rx_cnt);
+		this_cpu_add(stats->pcpu->rx_unicast, skb->len);
+	}
+}
+
+static void rtw89_traffic_stats_sum(struct rtw89_traffic_stats *stats,
+				    struct rtw89_traffic_stats_pcpu *sum)
+{
+	const struct rtw89_traffic_stats_pcpu *pcpu;
+	int cpu;
+
+	memset(sum, 0, sizeof(*sum));
+
+	for_each_possible_cpu(cpu) {
+		pcpu = per_cpu_ptr(stats->pcpu, cpu);
+		sum->tx_unicast += READ_ONCE(pcpu->tx_unicast);
+		sum->rx_unicast += READ_ONCE(pcpu->rx_unicast);
+		sum->tx_cnt += READ_ONCE(pcpu->tx_cnt);
+		sum->rx_cnt += READ_ONCE(pcpu->rx_cnt);
 	}
 }
 
+static void rtw89_tfc_est_kick(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_tfc_est *est = &rtwdev->tfc_est;
+
+	if (test_bit(RTW89_FLAG_TFC_EST_RUNNING, rtwdev->flags) ||
+	    !test_bit(RTW89_FLAG_RUNNING, rtwdev->flags))
+		return;
+
+	if (test_and_set_bit_lock(RTW89_FLAG_TFC_EST_RUNNING, rtwdev->flags))
+		return;
+
+	/* sample from now on, or the idle gap dilutes the first burst */
+	rtw89_traffic_stats_sum(&rtwdev->stats, &est->last);
+	est->last_time = ktime_get();
+
+	queue_delayed_work(rtwdev->txq_wq, &est->work,
+			   msecs_to_jiffies(RTW89_TFC_EST_PERIOD_MS));
+}
+
 void rtw89_get_default_chandef(struct cfg80211_chan_def *chandef)
 {
 	cfg80211_chandef_create(chandef, &rtw89_channels_2ghz[0],
@@ -367,6 +422,8 @@ void rtw89_set_channel(struct rtw89_dev *rtwdev)
 		return;
 
 	band_changed = rtw89_assign_entity_chan(rtwdev, sub_entity_idx, &chan);
+	if (band_changed)
+		rtw89_core_tx_desc_tmpl_invalidate(rtwdev);
 
 	rtw89_chip_set_channel_prepare(rtwdev, &bak, &chan, mac_idx, phy_idx);
 
@@ -406,6 +463,28 @@ rtw89_core_get_tx_type(struct rtw89_dev *rtwdev,
 	return RTW89_CORE_TX_TYPE_DATA;
 }
 
+static u8 rtw89_core_tx_get_ampdu_num(struct ieee80211_sta *sta, u8 tid)
+{
+	struct rtw89_sta *rtwsta = (struct rtw89_sta *)sta->drv_priv;
+
+	return (u8)((rtwsta->ampdu_params[tid].agg_num ?
+		     rtwsta->ampdu_params[tid].agg_num :
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 19, 0)
+		     4 << sta->ht_cap.ampdu_factor) - 1);
+#else
+		     4 << sta->deflink.ht_cap.ampdu_factor) - 1);
+#endif
+}
+
+static u8 rtw89_core_tx_get_ampdu_density(struct ieee80211_sta *sta)
+{
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 19, 0)
+	return sta->ht_cap.ampdu_density;
+#else
+	return sta->deflink.ht_cap.ampdu_density;
+#endif
+}
+
 static void
 rtw89_core_tx_update_ampdu_info(struct rtw89_dev *rtwdev,
 				struct rtw89_core_tx_request *tx_req,
@@ -414,8 +493,6 @@ rtw89_core_tx_update_ampdu_info(struct rtw89_dev *rtwdev,
 	struct ieee80211_sta *sta = tx_req->sta;
 	struct rtw89_tx_desc_info *desc_info = &tx_req->desc_info;
 	struct sk_buff *skb = tx_req->skb;
-	struct rtw89_sta *rtwsta;
-	u8 ampdu_num;
 	u8 tid;
 
 	if (pkt_type == PACKET_EAPOL) {
@@ -431,31 +508,44 @@ rtw89_core_tx_update_ampdu_info(struct rtw89_dev *rtwdev,
 		return;
 	}
 
+	desc_info->agg_en = true;
+
+	if (tx_req->desc_tmpl_hit) {
+		desc_info->ampdu_density = tx_req->tmpl_ampdu_density;
+		desc_info->ampdu_num = tx_req->tmpl_ampdu_num;
+		return;
+	}
+
 	tid = skb->priority & IEEE80211_QOS_CTL_TAG1D_MASK;
-	rtwsta = (struct rtw89_sta *)sta->drv_priv;
+	desc_info->ampdu_density = rtw89_core_tx_get_ampdu_density(sta);
+	desc_info->ampdu_num = rtw89_core_tx_get_ampdu_num(sta, tid);
+}
 
-	ampdu_num = (u8)((rtwsta->ampdu_params[tid].agg_num ?
-			  rtwsta->ampdu_params[tid].agg_num :
-#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 19, 0)
-			  4 << sta->ht_cap.ampdu_factor) - 1);
-#else
-			  4 << sta->deflink.ht_cap.ampdu_factor) - 1);
-#endif
+static void
+rtw89_core_tx_update_sec_iv(struct rtw89_dev *rtwdev,
+			    struct rtw89_tx_desc_info *desc_info,
+			    struct ieee80211_key_conf *key)
+{
+	const struct rtw89_chip_info *chip = rtwdev->chip;
+	u64 pn64;
 
-	desc_info->agg_en = true;
-#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 19, 0)
-	desc_info->ampdu_density = sta->ht_cap.ampdu_density;
-#else
-	desc_info->ampdu_density = sta->deflink.ht_cap.ampdu_density;
-#endif
-	desc_info->ampdu_num = ampdu_num;
+	if (!chip->hw_sec_hdr)
+		return;
+
+	pn64 = atomic64_inc_return(&key->tx_pn);
+	desc_info->sec_seq[0] = pn64;
+	desc_info->sec_seq[1] = pn64 >> 8;
+	desc_info->sec_seq[2] = pn64 >> 16;
+	desc_info->sec_seq[3] = pn64 >> 24;
+	desc_info->sec_seq[4] = pn64 >> 32;
+	desc_info->sec_seq[5] = pn64 >> 40;
+	desc_info->wp_offset = 1; /* in unit of 8 bytes for security header */
 }
 
 static void
 rtw89_core_tx_update_sec_key(struct rtw89_dev *rtwdev,
 			     struct rtw89_core_tx_request *tx_req)
 {
-	const struct rtw89_chip_info *chip = rtwdev->chip;
 	struct ieee80211_vif *vif = tx_req->vif;
 	struct ieee80211_sta *sta = tx_req->sta;
 	struct ieee80211_tx_info *info;
@@ -467,7 +557,6 @@ rtw89_core_tx_update_sec_key(struct rtw89_dev *rtwdev,
 	struct rtw89_tx_desc_info *desc_info = &tx_req->desc_info;
 	struct sk_buff *skb = tx_req->skb;
 	u8 sec_type = RTW89_SEC_KEY_TYPE_NONE;
-	u64 pn64;
 
 	if (!vif) {
 		rtw89_warn(rtwdev, "cannot set sec key without vif\n");
@@ -517,17 +606,7 @@ rtw89_core_tx_update_sec_key(struct rtw89_dev *rtwdev,
 	desc_info->sec_type = sec_type;
 	desc_info->sec_cam_idx = sec_cam->sec_cam_idx;
 
-	if (!chip->hw_sec_hdr)
-		return;
-
-	pn64 = atomic64_inc_return(&key->tx_pn);
-	desc_info->sec_seq[0] = pn64;
-	desc_info->sec_seq[1] = pn64 >> 8;
-	desc_info->sec_seq[2] = pn64 >> 16;
-	desc_info->sec_seq[3] = pn64 >> 24;
-	desc_info->sec_seq[4] = pn64 >> 32;
-	desc_info->sec_seq[5] = pn64 >> 40;
-	desc_info->wp_offset = 1; /* in unit of 8 bytes for security header */
+	rtw89_core_tx_update_sec_iv(rtwdev, desc_info, key);
 }
 
 static u16 rtw89_core_get_mgmt_rate(struct rtw89_dev *rtwdev,
@@ -766,6 +845,47 @@ static u16 rtw89_core_get_data_rate(struct rtw89_dev *rtwdev,
 #endif
 }
 
+static void rtw89_core_tx_apply_desc_tmpl(struct rtw89_tx_desc_info *desc_info,
+					  const struct rtw89_tx_desc_info *tmpl)
+{
+	desc_info->ch_dma = tmpl->ch_dma;
+	desc_info->tid_indicate = tmpl->tid_indicate;
+	desc_info->qsel = tmpl->qsel;
+	desc_info->mac_id = tmpl->mac_id;
+	desc_info->port = tmpl->port;
+	desc_info->er_cap = tmpl->er_cap;
+	desc_info->en_wd_info = tmpl->en_wd_info;
+	desc_info->sec_en = tmpl->sec_en;
+	desc_info->sec_keyid = tmpl->sec_keyid;
+	desc_info->sec_type = tmpl->sec_type;
+	desc_info->sec_cam_idx = tmpl->sec_cam_idx;
+	desc_info->data_retry_lowest_rate = tmpl->data_retry_lowest_rate;
+}
+
+static bool rtw89_core_tx_read_desc_tmpl(struct rtw89_core_tx_request *tx_req,
+					 const struct rtw89_tx_desc_tmpl *tmpl,
+					 u32 gen, struct ieee80211_key_conf *key)
+{
+	struct rtw89_tx_desc_info cached;
+	unsigned int seq;
+	bool hit;
+
+	do {
+		seq = read_seqcount_begin(&tmpl->seq);
+		hit = tmpl->gen == gen && tmpl->key == key;
+		if (hit) {
+			cached = tmpl->desc_info;
+			tx_req->tmpl_ampdu_num = tmpl->ampdu_num;
+			tx_req->tmpl_ampdu_density = tmpl->ampdu_density;
+		}
+	} while (read_seqcount_retry(&tmpl->seq, seq));
+
+	if (hit)
+		rtw89_core_tx_apply_desc_tmpl(&tx_req->desc_info, &cached);
+
+	return hit;
+}
+
 static void
 rtw89_core_tx_update_data_info(struct rtw89_dev *rtwdev,
 			       struct rtw89_core_tx_request *tx_req)
@@ -776,10 +896,28 @@ rtw89_core_tx_update_data_info(struct rtw89_dev *rtwdev,
 	struct rtw89_sta *rtwsta = sta_to_rtwsta_safe(sta);
 	struct rtw89_tx_desc_info *desc_info = &tx_req->desc_info;
 	struct sk_buff *skb = tx_req->skb;
+	struct ieee80211_key_conf *key = IEEE80211_SKB_CB(skb)->control.hw_key;
+	struct rtw89_tx_desc_tmpl *tmpl = NULL;
+	u8 ampdu_num, ampdu_density;
 	u8 tid, tid_indicate;
 	u8 qsel, ch_dma;
+	u32 gen = 0;
 
 	tid = skb->priority & IEEE80211_QOS_CTL_TAG1D_MASK;
+
+	/* frames to HIQ take the port of vif, so they aren't cached */
+	if (rtwsta && !desc_info->hiq && !rtw89_disable_tx_desc_tmpl) {
+		tmpl = &rtwsta->tx_desc_tmpl[tid];
+		gen = atomic_read(&rtwdev->tx_desc_tmpl_gen);
+
+		if (rtw89_core_tx_read_desc_tmpl(tx_req, tmpl, gen, key)) {
+			if (desc_info->sec_en)
+				rtw89_core_tx_update_sec_iv(rtwdev, desc_info, key);
+			tx_req->desc_tmpl_hit = true;
+			return;
+		}
+	}
+
 	tid_indicate = rtw89_core_get_tid_indicate(rtwdev, tid);
 	qsel = desc_info->hiq ? RTW89_TX_QSEL_B0_HI : rtw89_core_get_qsel(rtwdev, tid);
 	ch_dma = rtw89_core_get_ch_dma(rtwdev, qsel);
@@ -794,10 +932,30 @@ rtw89_core_tx_update_data_info(struct rtw89_dev *rtwdev,
 	/* enable wd_info for AMPDU */
 	desc_info->en_wd_info = true;
 
-	if (IEEE80211_SKB_CB(skb)->control.hw_key)
+	if (key)
 		rtw89_core_tx_update_sec_key(rtwdev, tx_req);
 
 	desc_info->data_retry_lowest_rate = rtw89_core_get_data_rate(rtwdev, tx_req);
+
+	if (!tmpl)
+		return;
+
+	ampdu_num = rtw89_core_tx_get_ampdu_num(sta, tid);
+	ampdu_density = rtw89_core_tx_get_ampdu_density(sta);
+
+	spin_lock_bh(&rtwsta->tx_desc_tmpl_lock);
+	write_seqcount_begin(&tmpl->seq);
+	tmpl->desc_info = *desc_info;
+	tmpl->key = key;
+	tmpl->ampdu_num = ampdu_num;
+	tmpl->ampdu_density = ampdu_density;
+	tmpl->gen = gen;
+	write_seqcount_end(&tmpl->seq);
+	spin_unlock_bh(&rtwsta->tx_desc_tmpl_lock);
+
+	tx_req->tmpl_ampdu_num = ampdu_num;
+	tx_req->tmpl_ampdu_density = ampdu_density;
+	tx_req->desc_tmpl_hit = true;
 }
 
 static enum btc_pkt_type
@@ -920,6 +1078,47 @@ void rtw89_core_tx_kick_off(struct rtw89_dev *rtwdev, u8 qsel)
 	rtw89_hci_tx_kick_off(rtwdev, ch_dma);
 }
 
+/* Frames written in a round of TX scheduling are kicked off once per ring
+ * at the end, to save the expensive write of the TX BD index.
+ */
+struct rtw89_tx_kick_batch {
+	DECLARE_BITMAP(pending_map, RTW89_TXCH_NUM);
+	u32 pending_cnt[RTW89_TXCH_NUM];
+};
+
+static void rtw89_core_tx_kick_defer(struct rtw89_dev *rtwdev,
+				     struct rtw89_tx_kick_batch *batch,
+				     u8 qsel, u32 cnt)
+{
+	u32 thold = READ_ONCE(rtw89_tx_kick_thold);
+	u8 ch_dma;
+
+	ch_dma = rtw89_core_get_ch_dma(rtwdev, qsel);
+
+	batch->pending_cnt[ch_dma] += cnt;
+	if (thold && batch->pending_cnt[ch_dma] < thold) {
+		set_bit(ch_dma, batch->pending_map);
+		return;
+	}
+
+	clear_bit(ch_dma, batch->pending_map);
+	batch->pending_cnt[ch_dma] = 0;
+	rtw89_hci_tx_kick_off(rtwdev, ch_dma);
+}
+
+static void rtw89_core_tx_kick_flush(struct rtw89_dev *rtwdev,
+				     struct rtw89_tx_kick_batch *batch)
+{
+	unsigned int ch_dma;
+
+	for_each_set_bit(ch_dma, batch->pending_map, RTW89_TXCH_NUM) {
+		batch->pending_cnt[ch_dma] = 0;
+		rtw89_hci_tx_kick_off(rtwdev, ch_dma);
+	}
+
+	bitmap_zero(batch->pending_map, RTW89_TXCH_NUM);
+}
+
 int rtw89_core_tx_kick_off_and_wait(struct rtw89_dev *rtwdev, struct sk_buff *skb,
 				    int qsel, unsigned int timeout)
 {
@@ -1005,6 +1204,7 @@ int rtw89_core_tx_write(struct rtw89_dev *rtwdev, struct ieee80211_vif *vif,
 
 	rtw89_traffic_stats_accu(rtwdev, &rtwdev->stats, skb, true);
 	rtw89_traffic_stats_accu(rtwdev, &rtwvif->stats, skb, true);
+	rtw89_tfc_est_kick(rtwdev);
 	rtw89_core_tx_update_desc_info(rtwdev, &tx_req);
 	rtw89_core_tx_wake(rtwdev, &tx_req);
 
@@ -1261,21 +1461,25 @@ static int rtw89_core_rx_process_mac_ppdu(struct rtw89_dev *rtwdev,
 	return 0;
 }
 
-static void rtw89_core_rx_process_phy_ppdu_iter(void *data,
-						struct ieee80211_sta *sta)
+static void rtw89_core_rx_process_phy_ppdu_sta(struct rtw89_dev *rtwdev,
+					       struct rtw89_rx_phy_ppdu *phy_ppdu)
 {
-	struct rtw89_sta *rtwsta = (struct rtw89_sta *)sta->drv_priv;
-	struct rtw89_rx_phy_ppdu *phy_ppdu = (struct rtw89_rx_phy_ppdu *)data;
-	struct rtw89_dev *rtwdev = rtwsta->rtwdev;
 	struct rtw89_hal *hal = &rtwdev->hal;
 	u8 ant_num = hal->ant_diversity ? 2 : rtwdev->chip->rf_path_num;
 	u8 ant_pos = U8_MAX;
 	u8 evm_pos = 0;
+	struct rtw89_sta *rtwsta;
 	int i;
 
-	if (rtwsta->mac_id != phy_ppdu->mac_id || !phy_ppdu->to_self)
+	if (!phy_ppdu->to_self)
 		return;
 
+	rcu_read_lock();
+
+	rtwsta = rtw89_sta_rcu_dereference(rtwdev, phy_ppdu->mac_id);
+	if (!rtwsta)
+		goto out;
+
 	if (hal->ant_diversity && hal->antenna_rx) {
 		ant_pos = __ffs(hal->antenna_rx);
 		evm_pos = ant_pos;
@@ -1295,6 +1499,8 @@ static void rtw89_core_rx_process_phy_ppdu_iter(void *data,
 		ewma_evm_add(&rtwsta->evm_min[evm_pos], phy_ppdu->ofdm.evm_min);
 		ewma_evm_add(&rtwsta->evm_max[evm_pos], phy_ppdu->ofdm.evm_max);
 	}
+out:
+	rcu_read_unlock();
 }
 
 #define VAR_LEN 0xff
@@ -1441,9 +1647,7 @@ static void rtw89_core_rx_process_phy_sts(struct rtw89_dev *rtwdev,
 	else
 		phy_ppdu->valid = true;
 
-	ieee80211_iterate_stations_atomic(rtwdev->hw,
-					  rtw89_core_rx_process_phy_ppdu_iter,
-					  phy_ppdu);
+	rtw89_core_rx_process_phy_ppdu_sta(rtwdev, phy_ppdu);
 }
 
 static u8 rtw89_rxdesc_to_nl_he_gi(struct rtw89_dev *rtwdev,
@@ -1500,14 +1704,6 @@ static bool rtw89_core_rx_ppdu_match(struct rtw89_dev *rtwdev,
 	return ret;
 }
 
-struct rtw89_vif_rx_stats_iter_data {
-	struct rtw89_dev *rtwdev;
-	struct rtw89_rx_phy_ppdu *phy_ppdu;
-	struct rtw89_rx_desc_info *desc_info;
-	struct sk_buff *skb;
-	const u8 *bssid;
-};
-
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 0, 0)
 static void rtw89_stats_trigger_frame(struct rtw89_dev *rtwdev,
 				      struct ieee80211_vif *vif,
@@ -1614,67 +1810,109 @@ static void rtw89_core_cancel_6ghz_probe_tx(struct rtw89_dev *rtwdev,
 		ieee80211_queue_work(rtwdev->hw, &rtwdev->cancel_6ghz_probe_work);
 }
 
-static void rtw89_vif_rx_stats_iter(void *data, u8 *mac,
-				    struct ieee80211_vif *vif)
+static void rtw89_core_bcn_rssi_offload(struct rtw89_dev *rtwdev,
+					struct rtw89_vif *rtwvif,
+					struct rtw89_rx_phy_ppdu *phy_ppdu)
+{
+	if (!phy_ppdu || !RTW89_CHK_FW_FEATURE(BEACON_FILTER, &rtwdev->fw))
+		return;
+
+	/* firmware only needs a coarse RSSI to evaluate CQM, so don't send
+	 * H2C for every beacon unless the RSSI has moved noticeably.
+	 */
+	if (abs((int)phy_ppdu->rssi_avg - rtwvif->bcn_rssi_ofld) < RTW89_BCN_RSSI_OFLD_DELTA &&
+	    time_before(jiffies, rtwvif->bcn_rssi_ofld_time + RTW89_BCN_RSSI_OFLD_INTVL))
+		return;
+
+	if (rtw89_fw_h2c_rssi_offload(rtwdev, phy_ppdu))
+		return;
+
+	rtwvif->bcn_rssi_ofld = phy_ppdu->rssi_avg;
+	rtwvif->bcn_rssi_ofld_time = jiffies;
+}
+
+/* caller must hold rcu_read_lock() */
+static struct rtw89_vif *
+rtw89_core_rx_vif_lookup(struct rtw89_dev *rtwdev,
+			 struct rtw89_rx_desc_info *desc_info,
+			 const u8 *bssid)
+{
+	struct rtw89_vif *rtwvif;
+	struct rtw89_sta *rtwsta;
+	u8 port;
+
+	/* frames from a peer in address CAM carry its mac_id, which leads
+	 * to the vif directly
+	 */
+	if (desc_info->long_rxdesc && desc_info->addr_cam_valid) {
+		rtwsta = rtw89_sta_rcu_dereference(rtwdev, desc_info->mac_id);
+		if (rtwsta && ether_addr_equal(rtwsta->rtwvif->bssid, bssid))
+			return rtwsta->rtwvif;
+	}
+
+	for (port = 0; port < RTW89_PORT_NUM; port++) {
+		rtwvif = rcu_dereference(rtwdev->vif_on_port[port]);
+		if (rtwvif && ether_addr_equal(rtwvif->bssid, bssid))
+			return rtwvif;
+	}
+
+	return NULL;
+}
+
+static void rtw89_core_rx_stats(struct rtw89_dev *rtwdev,
+				struct rtw89_rx_phy_ppdu *phy_ppdu,
+				struct rtw89_rx_desc_info *desc_info,
+				struct sk_buff *skb)
 {
-	struct rtw89_vif *rtwvif = (struct rtw89_vif *)vif->drv_priv;
-	struct rtw89_vif_rx_stats_iter_data *iter_data = data;
-	struct rtw89_dev *rtwdev = iter_data->rtwdev;
 	struct rtw89_pkt_stat *pkt_stat = &rtwdev->phystat.cur_pkt_stat;
-	struct rtw89_rx_desc_info *desc_info = iter_data->desc_info;
-	struct sk_buff *skb = iter_data->skb;
 	struct ieee80211_hdr *hdr = (struct ieee80211_hdr *)skb->data;
-	struct rtw89_rx_phy_ppdu *phy_ppdu = iter_data->phy_ppdu;
-	const u8 *bssid = iter_data->bssid;
+	const u8 *bssid = get_hdr_bssid(hdr);
+	struct ieee80211_vif *vif;
+	struct rtw89_vif *rtwvif;
+
+	rtw89_traffic_stats_accu(rtwdev, &rtwdev->stats, skb, false);
+	rtw89_tfc_est_kick(rtwdev);
 
 	if (rtwdev->scanning &&
 	    (ieee80211_is_beacon(hdr->frame_control) ||
 	     ieee80211_is_probe_resp(hdr->frame_control)))
 		rtw89_core_cancel_6ghz_probe_tx(rtwdev, skb);
 
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 0, 0)
-	if (!vif->bss_conf.bssid)
-		return;
+	rcu_read_lock();
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 0, 0)
 	if (ieee80211_is_trigger(hdr->frame_control)) {
-		rtw89_stats_trigger_frame(rtwdev, vif, skb);
-		return;
+		struct ieee80211_trigger *tf = (struct ieee80211_trigger *)hdr;
+
+		rtwvif = rtw89_core_rx_vif_lookup(rtwdev, desc_info, tf->ta);
+		if (rtwvif)
+			rtw89_stats_trigger_frame(rtwdev, rtwvif_to_vif(rtwvif), skb);
+		goto out;
 	}
 #endif
 
-	if (!ether_addr_equal(vif->bss_conf.bssid, bssid))
-		return;
+	rtwvif = rtw89_core_rx_vif_lookup(rtwdev, desc_info, bssid);
+	if (!rtwvif)
+		goto out;
+
+	vif = rtwvif_to_vif(rtwvif);
 
 	if (ieee80211_is_beacon(hdr->frame_control)) {
 		if (vif->type == NL80211_IFTYPE_STATION)
-			rtw89_fw_h2c_rssi_offload(rtwdev, phy_ppdu);
+			rtw89_core_bcn_rssi_offload(rtwdev, rtwvif, phy_ppdu);
 		pkt_stat->beacon_nr++;
 	}
 
 	if (!ether_addr_equal(vif->addr, hdr->addr1))
-		return;
+		goto out;
 
 	if (desc_info->data_rate < RTW89_HW_RATE_NR)
 		pkt_stat->rx_rate_cnt[desc_info->data_rate]++;
 
 	rtw89_traffic_stats_accu(rtwdev, &rtwvif->stats, skb, false);
-}
 
-static void rtw89_core_rx_stats(struct rtw89_dev *rtwdev,
-				struct rtw89_rx_phy_ppdu *phy_ppdu,
-				struct rtw89_rx_desc_info *desc_info,
-				struct sk_buff *skb)
-{
-	struct rtw89_vif_rx_stats_iter_data iter_data;
-
-	rtw89_traffic_stats_accu(rtwdev, &rtwdev->stats, skb, false);
-
-	iter_data.rtwdev = rtwdev;
-	iter_data.phy_ppdu = phy_ppdu;
-	iter_data.desc_info = desc_info;
-	iter_data.skb = skb;
-	iter_data.bssid = get_hdr_bssid((struct ieee80211_hdr *)skb->data);
-	rtw89_iterate_vifs_bh(rtwdev, rtw89_vif_rx_stats_iter, &iter_data);
+out:
+	rcu_read_unlock();
 }
 
 static void rtw89_correct_cck_chan(struct rtw89_dev *rtwdev,
@@ -1739,22 +1977,94 @@ static void rtw89_core_rx_to_mac80211(struct rtw89_dev *rtwdev,
 				      struct sk_buff *skb_ppdu,
 				      struct ieee80211_rx_status *rx_status)
 {
-	struct napi_struct *napi = &rtwdev->napi;
-
-	/* In low power mode, napi isn't scheduled. Receive it to netif. */
-	if (unlikely(!test_bit(NAPI_STATE_SCHED, &napi->state)))
-		napi = NULL;
-
 	rtw89_core_hw_to_sband_rate(rx_status);
 	rtw89_core_rx_stats(rtwdev, phy_ppdu, desc_info, skb_ppdu);
 	rtw89_core_update_radiotap(rtwdev, skb_ppdu, rx_status);
-	/* In low power mode, it does RX in thread context. */
-	local_bh_disable();
-	ieee80211_rx_napi(rtwdev->hw, NULL, skb_ppdu, napi);
-	local_bh_enable();
 	rtwdev->napi_budget_countdown--;
+
+	if (rtwdev->rx_batching) {
+		list_add_tail(&skb_ppdu->list, &rtwdev->rx_batch_list);
+		return;
+	}
+
+	ieee80211_rx_napi(rtwdev->hw, NULL, skb_ppdu, &rtwdev->napi);
 }
 
+void rtw89_core_rx_batch_begin(struct rtw89_dev *rtwdev)
+{
+	rtwdev->rx_batching = true;
+}
+EXPORT_SYMBOL(rtw89_core_rx_batch_begin);
+
+static void rtw89_core_flush_ppdu_rx_queue(struct rtw89_dev *rtwdev,
+					   struct rtw89_rx_desc_info *desc_info);
+
+static void rtw89_core_rx_expire_ppdu_sts(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_ppdu_sts_info *ppdu_sts = &rtwdev->ppdu_sts;
+	/* no descriptor of its own, so keep the rate out of statistics */
+	struct rtw89_rx_desc_info desc_info = {.data_rate = RTW89_HW_RATE_NR};
+	ktime_t now = ktime_get();
+	bool pending = false;
+	u8 band;
+
+	for (band = 0; band < RTW89_PHY_MAX; band++) {
+		if (skb_queue_empty(&ppdu_sts->rx_queue[band]))
+			continue;
+
+		if (ktime_us_delta(now, ppdu_sts->queued_time[band]) <
+		    RTW89_PPDU_STS_TIMEOUT_US) {
+			pending = true;
+			continue;
+		}
+
+		desc_info.bb_sel = band == RTW89_PHY_1;
+		rtw89_core_flush_ppdu_rx_queue(rtwdev, &desc_info);
+		ppdu_sts->timeout++;
+	}
+
+	if (pending && !hrtimer_active(&ppdu_sts->flush_timer))
+		hrtimer_start(&ppdu_sts->flush_timer,
+			      us_to_ktime(RTW89_PPDU_STS_TIMEOUT_US),
+			      HRTIMER_MODE_REL);
+}
+
+void rtw89_core_rx_batch_end(struct rtw89_dev *rtwdev)
+{
+	struct napi_struct *napi = &rtwdev->napi;
+	struct sk_buff *skb, *tmp;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 13, 0)
+	LIST_HEAD(list);
+#endif
+
+	rtw89_core_rx_expire_ppdu_sts(rtwdev);
+
+	rtwdev->rx_batching = false;
+
+	if (list_empty(&rtwdev->rx_batch_list))
+		return;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 13, 0)
+	rcu_read_lock();
+	list_for_each_entry_safe(skb, tmp, &rtwdev->rx_batch_list, list) {
+		skb_list_del_init(skb);
+		ieee80211_rx_list(rtwdev->hw, NULL, skb, &list);
+	}
+	rcu_read_unlock();
+
+	list_for_each_entry_safe(skb, tmp, &list, list) {
+		skb_list_del_init(skb);
+		napi_gro_receive(napi, skb);
+	}
+#else
+	list_for_each_entry_safe(skb, tmp, &rtwdev->rx_batch_list, list) {
+		skb_list_del_init(skb);
+		ieee80211_rx_napi(rtwdev->hw, NULL, skb, napi);
+	}
+#endif
+}
+EXPORT_SYMBOL(rtw89_core_rx_batch_end);
+
 static void rtw89_core_rx_pending_skb(struct rtw89_dev *rtwdev,
 				      struct rtw89_rx_phy_ppdu *phy_ppdu,
 				      struct rtw89_rx_desc_info *desc_info,
@@ -1762,20 +2072,32 @@ static void rtw89_core_rx_pending_skb(struct rtw89_dev *rtwdev,
 {
 	u8 band = desc_info->bb_sel ? RTW89_PHY_1 : RTW89_PHY_0;
 	int curr = rtwdev->ppdu_sts.curr_rx_ppdu_cnt[band];
+	struct rtw89_ppdu_sts_info *ppdu_sts = &rtwdev->ppdu_sts;
 	struct sk_buff *skb_ppdu = NULL, *tmp;
 	struct ieee80211_rx_status *rx_status;
+	bool matched = false;
 
 	if (curr > RTW89_MAX_PPDU_CNT)
 		return;
 
-	skb_queue_walk_safe(&rtwdev->ppdu_sts.rx_queue[band], skb_ppdu, tmp) {
-		skb_unlink(skb_ppdu, &rtwdev->ppdu_sts.rx_queue[band]);
+	if (skb_queue_empty(&ppdu_sts->rx_queue[band]))
+		return;
+
+	skb_queue_walk_safe(&ppdu_sts->rx_queue[band], skb_ppdu, tmp) {
+		skb_unlink(skb_ppdu, &ppdu_sts->rx_queue[band]);
 		rx_status = IEEE80211_SKB_RXCB(skb_ppdu);
-		if (rtw89_core_rx_ppdu_match(rtwdev, desc_info, rx_status))
+		if (rtw89_core_rx_ppdu_match(rtwdev, desc_info, rx_status)) {
 			rtw89_chip_query_ppdu(rtwdev, phy_ppdu, rx_status);
+			matched = true;
+		}
 		rtw89_correct_cck_chan(rtwdev, rx_status);
 		rtw89_core_rx_to_mac80211(rtwdev, phy_ppdu, desc_info, skb_ppdu, rx_status);
 	}
+
+	if (matched)
+		ppdu_sts->matched++;
+	else
+		ppdu_sts->unmatched++;
 }
 
 static void rtw89_core_rx_process_ppdu_sts(struct rtw89_dev *rtwdev,
@@ -1819,11 +2141,11 @@ static void rtw89_core_rx_process_report(struct rtw89_dev *rtwdev,
 	}
 }
 
-void rtw89_core_query_rxdesc(struct rtw89_dev *rtwdev,
-			     struct rtw89_rx_desc_info *desc_info,
-			     u8 *data, u32 data_offset)
+static __always_inline void
+__rtw89_core_query_rxdesc(struct rtw89_dev *rtwdev,
+			  struct rtw89_rx_desc_info *desc_info,
+			  u8 *data, u32 data_offset, bool bw_v1)
 {
-	const struct rtw89_chip_info *chip = rtwdev->chip;
 	struct rtw89_rxdesc_short *rxd_s;
 	struct rtw89_rxdesc_long *rxd_l;
 	u8 shift_len, drv_info_len;
@@ -1834,7 +2156,7 @@ void rtw89_core_query_rxdesc(struct rtw89_dev *rtwdev,
 	desc_info->long_rxdesc = le32_get_bits(rxd_s->dword0,  AX_RXD_LONG_RXD);
 	desc_info->pkt_type = le32_get_bits(rxd_s->dword0,  AX_RXD_RPKT_TYPE_MASK);
 	desc_info->mac_info_valid = le32_get_bits(rxd_s->dword0, AX_RXD_MAC_INFO_VLD);
-	if (chip->chip_id == RTL8852C)
+	if (bw_v1)
 		desc_info->bw = le32_get_bits(rxd_s->dword1, AX_RXD_BW_v1_MASK);
 	else
 		desc_info->bw = le32_get_bits(rxd_s->dword1, AX_RXD_BW_MASK);
@@ -1871,37 +2193,28 @@ void rtw89_core_query_rxdesc(struct rtw89_dev *rtwdev,
 	desc_info->mac_id = le32_get_bits(rxd_l->dword5, AX_RXD_MAC_ID_MASK);
 	desc_info->rx_pl_id = le32_get_bits(rxd_l->dword5, AX_RXD_RX_PL_ID_MASK);
 }
-EXPORT_SYMBOL(rtw89_core_query_rxdesc);
-
-struct rtw89_core_iter_rx_status {
-	struct rtw89_dev *rtwdev;
-	struct ieee80211_rx_status *rx_status;
-	struct rtw89_rx_desc_info *desc_info;
-	u8 mac_id;
-};
 
-static
-void rtw89_core_stats_sta_rx_status_iter(void *data, struct ieee80211_sta *sta)
+void rtw89_core_query_rxdesc(struct rtw89_dev *rtwdev,
+			     struct rtw89_rx_desc_info *desc_info,
+			     u8 *data, u32 data_offset)
 {
-	struct rtw89_core_iter_rx_status *iter_data =
-				(struct rtw89_core_iter_rx_status *)data;
-	struct ieee80211_rx_status *rx_status = iter_data->rx_status;
-	struct rtw89_sta *rtwsta = (struct rtw89_sta *)sta->drv_priv;
-	struct rtw89_rx_desc_info *desc_info = iter_data->desc_info;
-	u8 mac_id = iter_data->mac_id;
-
-	if (mac_id != rtwsta->mac_id)
-		return;
+	__rtw89_core_query_rxdesc(rtwdev, desc_info, data, data_offset, false);
+}
+EXPORT_SYMBOL(rtw89_core_query_rxdesc);
 
-	rtwsta->rx_status = *rx_status;
-	rtwsta->rx_hw_rate = desc_info->data_rate;
+void rtw89_core_query_rxdesc_v1(struct rtw89_dev *rtwdev,
+				struct rtw89_rx_desc_info *desc_info,
+				u8 *data, u32 data_offset)
+{
+	__rtw89_core_query_rxdesc(rtwdev, desc_info, data, data_offset, true);
 }
+EXPORT_SYMBOL(rtw89_core_query_rxdesc_v1);
 
 static void rtw89_core_stats_sta_rx_status(struct rtw89_dev *rtwdev,
 					   struct rtw89_rx_desc_info *desc_info,
 					   struct ieee80211_rx_status *rx_status)
 {
-	struct rtw89_core_iter_rx_status iter_data;
+	struct rtw89_sta *rtwsta;
 
 	if (!desc_info->addr1_match || !desc_info->long_rxdesc)
 		return;
@@ -1909,13 +2222,15 @@ static void rtw89_core_stats_sta_rx_status(struct rtw89_dev *rtwdev,
 	if (desc_info->frame_type != RTW89_RX_TYPE_DATA)
 		return;
 
-	iter_data.rtwdev = rtwdev;
-	iter_data.rx_status = rx_status;
-	iter_data.desc_info = desc_info;
-	iter_data.mac_id = desc_info->mac_id;
-	ieee80211_iterate_stations_atomic(rtwdev->hw,
-					  rtw89_core_stats_sta_rx_status_iter,
-					  &iter_data);
+	rcu_read_lock();
+
+	rtwsta = rtw89_sta_rcu_dereference(rtwdev, desc_info->mac_id);
+	if (rtwsta) {
+		rtwsta->rx_status = *rx_status;
+		rtwsta->rx_hw_rate = desc_info->data_rate;
+	}
+
+	rcu_read_unlock();
 }
 
 static void rtw89_core_update_rx_status(struct rtw89_dev *rtwdev,
@@ -2021,6 +2336,32 @@ static void rtw89_core_flush_ppdu_rx_queue(struct rtw89_dev *rtwdev,
 	}
 }
 
+/* PHY status of this frame is applied to station stats when its report
+ * arrives, so take the signal from the averaged station RSSI here.
+ */
+static void rtw89_core_rx_fill_sta_signal(struct rtw89_dev *rtwdev,
+					  struct rtw89_rx_desc_info *desc_info,
+					  struct ieee80211_rx_status *rx_status)
+{
+	struct rtw89_sta *rtwsta;
+	unsigned long rssi = 0;
+
+	if (desc_info->addr_cam_valid) {
+		rcu_read_lock();
+		rtwsta = rtw89_sta_rcu_dereference(rtwdev, desc_info->mac_id);
+		if (rtwsta)
+			rssi = ewma_rssi_read(&rtwsta->avg_rssi);
+		rcu_read_unlock();
+	}
+
+	if (!rssi) {
+		rx_status->flag |= RX_FLAG_NO_SIGNAL_VAL;
+		return;
+	}
+
+	rx_status->signal = RTW89_RSSI_RAW_TO_DBM(rssi);
+}
+
 void rtw89_core_rx(struct rtw89_dev *rtwdev,
 		   struct rtw89_rx_desc_info *desc_info,
 		   struct sk_buff *skb)
@@ -2029,6 +2370,8 @@ void rtw89_core_rx(struct rtw89_dev *rtwdev,
 	struct rtw89_ppdu_sts_info *ppdu_sts = &rtwdev->ppdu_sts;
 	u8 ppdu_cnt = desc_info->ppdu_cnt;
 	u8 band = desc_info->bb_sel ? RTW89_PHY_1 : RTW89_PHY_0;
+	struct sk_buff_head *rx_queue = &ppdu_sts->rx_queue[band];
+	struct ieee80211_hdr *hdr;
 
 	if (desc_info->pkt_type != RTW89_CORE_RX_TYPE_WIFI) {
 		rtw89_core_rx_process_report(rtwdev, desc_info, skb);
@@ -2036,18 +2379,49 @@ void rtw89_core_rx(struct rtw89_dev *rtwdev,
 	}
 
 	if (ppdu_sts->curr_rx_ppdu_cnt[band] != ppdu_cnt) {
-		rtw89_core_flush_ppdu_rx_queue(rtwdev, desc_info);
+		if (!skb_queue_empty(rx_queue)) {
+			rtw89_core_flush_ppdu_rx_queue(rtwdev, desc_info);
+			ppdu_sts->unmatched++;
+		}
 		ppdu_sts->curr_rx_ppdu_cnt[band] = ppdu_cnt;
 	}
 
 	rx_status = IEEE80211_SKB_RXCB(skb);
 	memset(rx_status, 0, sizeof(*rx_status));
 	rtw89_core_update_rx_status(rtwdev, desc_info, rx_status);
-	if (desc_info->long_rxdesc &&
-	    BIT(desc_info->frame_type) & PPDU_FILTER_BITMAP)
-		skb_queue_tail(&ppdu_sts->rx_queue[band], skb);
-	else
+	if (!desc_info->long_rxdesc ||
+	    !(BIT(desc_info->frame_type) & PPDU_FILTER_BITMAP)) {
 		rtw89_core_rx_to_mac80211(rtwdev, NULL, desc_info, skb, rx_status);
+		return;
+	}
+
+	/* beacons still wait for PPDU status to feed beacon RSSI offload */
+	hdr = (struct ieee80211_hdr *)skb->data;
+	if (READ_ONCE(rtw89_ppdu_sts_immediate) &&
+	    !ieee80211_is_beacon(hdr->frame_control)) {
+		rtw89_core_rx_fill_sta_signal(rtwdev, desc_info, rx_status);
+		rtw89_core_rx_to_mac80211(rtwdev, NULL, desc_info, skb, rx_status);
+		ppdu_sts->immediate++;
+		return;
+	}
+
+	if (skb_queue_len(rx_queue) >= RTW89_PPDU_STS_RX_QUEUE_MAX) {
+		/* keep subframes in order by flushing earlier ones first */
+		rtw89_core_flush_ppdu_rx_queue(rtwdev, desc_info);
+		rtw89_core_rx_to_mac80211(rtwdev, NULL, desc_info, skb, rx_status);
+		ppdu_sts->overflow++;
+		return;
+	}
+
+	if (skb_queue_empty(rx_queue)) {
+		ppdu_sts->queued_time[band] = ktime_get();
+		if (!hrtimer_active(&ppdu_sts->flush_timer))
+			hrtimer_start(&ppdu_sts->flush_timer,
+				      us_to_ktime(RTW89_PPDU_STS_TIMEOUT_US),
+				      HRTIMER_MODE_REL);
+	}
+
+	skb_queue_tail(rx_queue, skb);
 }
 EXPORT_SYMBOL(rtw89_core_rx);
 
@@ -2057,6 +2431,8 @@ void rtw89_core_napi_start(struct rtw89_dev *rtwdev)
 		return;
 
 	napi_enable(&rtwdev->napi);
+	if (rtwdev->hci.ops->napi_poll_tx)
+		napi_enable(&rtwdev->napi_tx);
 }
 EXPORT_SYMBOL(rtw89_core_napi_start);
 
@@ -2067,6 +2443,11 @@ void rtw89_core_napi_stop(struct rtw89_dev *rtwdev)
 
 	napi_synchronize(&rtwdev->napi);
 	napi_disable(&rtwdev->napi);
+	hrtimer_cancel(&rtwdev->ppdu_sts.flush_timer);
+	if (rtwdev->hci.ops->napi_poll_tx) {
+		napi_synchronize(&rtwdev->napi_tx);
+		napi_disable(&rtwdev->napi_tx);
+	}
 }
 EXPORT_SYMBOL(rtw89_core_napi_stop);
 
@@ -2076,9 +2457,15 @@ void rtw89_core_napi_init(struct rtw89_dev *rtwdev)
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 1, 0)
 	netif_napi_add(&rtwdev->netdev, &rtwdev->napi,
 		       rtwdev->hci.ops->napi_poll);
+	if (rtwdev->hci.ops->napi_poll_tx)
+		netif_napi_add_tx(&rtwdev->netdev, &rtwdev->napi_tx,
+				  rtwdev->hci.ops->napi_poll_tx);
 #else
 	netif_napi_add(&rtwdev->netdev, &rtwdev->napi,
 		       rtwdev->hci.ops->napi_poll, NAPI_POLL_WEIGHT);
+	if (rtwdev->hci.ops->napi_poll_tx)
+		netif_tx_napi_add(&rtwdev->netdev, &rtwdev->napi_tx,
+				  rtwdev->hci.ops->napi_poll_tx, NAPI_POLL_WEIGHT);
 #endif
 }
 EXPORT_SYMBOL(rtw89_core_napi_init);
@@ -2087,9 +2474,19 @@ void rtw89_core_napi_deinit(struct rtw89_dev *rtwdev)
 {
 	rtw89_core_napi_stop(rtwdev);
 	netif_napi_del(&rtwdev->napi);
+	if (rtwdev->hci.ops->napi_poll_tx)
+		netif_napi_del(&rtwdev->napi_tx);
 }
 EXPORT_SYMBOL(rtw89_core_napi_deinit);
 
+/* caller must disable BH */
+void rtw89_core_napi_schedule(struct rtw89_dev *rtwdev)
+{
+	napi_schedule(&rtwdev->napi);
+	if (rtwdev->hci.ops->napi_poll_tx)
+		napi_schedule(&rtwdev->napi_tx);
+}
+
 static void rtw89_core_ba_work(struct work_struct *work)
 {
 	struct rtw89_dev *rtwdev =
@@ -2242,8 +2639,11 @@ static void rtw89_core_txq_push(struct rtw89_dev *rtwdev,
 	struct ieee80211_txq *txq = rtw89_txq_to_txq(rtwtxq);
 	struct ieee80211_vif *vif = txq->vif;
 	struct ieee80211_sta *sta = txq->sta;
+	struct rtw89_sta *rtwsta = sta_to_rtwsta_safe(sta);
 	struct sk_buff *skb;
+	u32 airtime = 0;
 	unsigned long i;
+	u32 skb_airtime;
 	int ret;
 
 	rcu_read_lock();
@@ -2254,14 +2654,19 @@ static void rtw89_core_txq_push(struct rtw89_dev *rtwdev,
 			goto out;
 		}
 		rtw89_core_txq_check_agg(rtwdev, rtwtxq, skb);
+		/* read before TX, since completion may free skb at once */
+		skb_airtime = rtw89_tx_airtime_est(skb);
 		ret = rtw89_core_tx_write(rtwdev, vif, sta, skb, NULL);
 		if (ret) {
 			rtw89_err(rtwdev, "failed to push txq: %d\n", ret);
 			ieee80211_free_txskb(rtwdev->hw, skb);
 			break;
 		}
+		airtime += skb_airtime;
 	}
 out:
+	if (rtwsta && airtime)
+		atomic_add(airtime, &rtwsta->airtime_inflight[txq->ac]);
 	rcu_read_unlock();
 }
 
@@ -2275,40 +2680,163 @@ static u32 rtw89_check_and_reclaim_tx_resource(struct rtw89_dev *rtwdev, u8 tid)
 	return rtw89_hci_check_and_reclaim_tx_resource(rtwdev, ch_dma);
 }
 
+/* call before reporting TX status, which clears the estimate in skb */
+void rtw89_core_sta_airtime_release(struct rtw89_dev *rtwdev,
+				    struct rtw89_sta *rtwsta,
+				    struct sk_buff *skb)
+{
+	u32 cap = READ_ONCE(rtw89_airtime_inflight_us);
+	u32 airtime = rtw89_tx_airtime_est(skb);
+	u8 tid = skb->priority & IEEE80211_QOS_CTL_TID_MASK;
+	u8 ac = ieee80211_ac_from_tid(tid);
+	int inflight;
+
+	if (!airtime)
+		return;
+
+	inflight = atomic_sub_return(airtime, &rtwsta->airtime_inflight[ac]);
+	if (inflight < 0) {
+		atomic_set(&rtwsta->airtime_inflight[ac], 0);
+		inflight = 0;
+	}
+
+	/* resume the AC held by rtw89_core_txq_airtime_limit() */
+	if (cap && inflight < cap && inflight + airtime >= cap)
+		rtw89_core_txq_sched_queue(rtwdev, ac);
+}
+EXPORT_SYMBOL(rtw89_core_sta_airtime_release);
+
+/* Limit frames of a station by airtime it already has in hardware per AC, so
+ * a slow client can't fill TX rings with long frames and delay the others,
+ * while a BE backlog doesn't hold back VO/VI of the same station.
+ */
+static unsigned long rtw89_core_txq_airtime_limit(struct rtw89_dev *rtwdev,
+						  struct ieee80211_txq *txq,
+						  unsigned long frame_cnt,
+						  unsigned long byte_cnt,
+						  bool *reinvoke)
+{
+	struct rtw89_sta *rtwsta = sta_to_rtwsta_safe(txq->sta);
+	u32 cap = READ_ONCE(rtw89_airtime_inflight_us);
+	u32 inflight, bit_rate, per_frame;
+	unsigned long limit;
+
+	if (!rtwsta || !cap || !frame_cnt)
+		return frame_cnt;
+
+	inflight = max(atomic_read(&rtwsta->airtime_inflight[txq->ac]), 0);
+	if (inflight >= cap) {
+		*reinvoke = true;
+		return 0;
+	}
+
+	bit_rate = READ_ONCE(rtwsta->ra_report.bit_rate);
+	if (!bit_rate)
+		return frame_cnt;
+
+	/* bit_rate is in unit of 100 kbps */
+	per_frame = DIV_ROUND_UP(byte_cnt / frame_cnt * 80, bit_rate);
+	if (!per_frame)
+		return frame_cnt;
+
+	limit = DIV_ROUND_UP(cap - inflight, per_frame);
+	if (limit >= frame_cnt)
+		return frame_cnt;
+
+	/* the estimate above may differ from tx_time_est charged per frame,
+	 * so inflight can settle below the cap without a release crossing it
+	 */
+	*reinvoke = true;
+
+	return limit;
+}
+
+static enum hrtimer_restart rtw89_core_agg_wait_timer(struct hrtimer *timer)
+{
+	struct rtw89_txq_sched *sched = container_of(timer, struct rtw89_txq_sched,
+						     agg_wait_timer);
+
+	rtw89_core_txq_sched_queue(sched->rtwdev, sched->ac);
+
+	return HRTIMER_NORESTART;
+}
+
+static void rtw89_core_txq_agg_wait_arm(struct rtw89_txq_sched *sched,
+					ktime_t expires)
+{
+	struct hrtimer *timer = &sched->agg_wait_timer;
+
+	/* one timer serves all TXQs of the AC, so keep the earliest deadline */
+	if (hrtimer_active(timer) &&
+	    !ktime_before(expires, hrtimer_get_expires(timer)))
+		return;
+
+	hrtimer_start(timer, expires, HRTIMER_MODE_ABS);
+}
+
+static void rtw89_core_txq_agg_wait_end(struct rtw89_txq *rtwtxq,
+					unsigned long frame_cnt)
+{
+	if (!rtwtxq->wait_start)
+		return;
+
+	/* a wait always starts with one frame held */
+	rtwtxq->wait_cnt++;
+	rtwtxq->wait_gained += frame_cnt - 1;
+	if (frame_cnt <= 1)
+		rtwtxq->wait_expired++;
+	rtwtxq->wait_start = 0;
+}
+
+/* Hold the last frame of a TXQ for up to agg_wait_us of its AC, so more
+ * frames can join the same A-MPDU under heavy traffic.
+ */
 static bool rtw89_core_txq_agg_wait(struct rtw89_dev *rtwdev,
 				    struct ieee80211_txq *txq,
 				    unsigned long *frame_cnt,
-				    bool *sched_txq, bool *reinvoke)
+				    bool *sched_txq)
 {
 	struct rtw89_txq *rtwtxq = (struct rtw89_txq *)txq->drv_priv;
 	struct ieee80211_sta *sta = txq->sta;
 	struct rtw89_sta *rtwsta = sta ? (struct rtw89_sta *)sta->drv_priv : NULL;
+	struct rtw89_txq_sched *sched = &rtwdev->txq_sched[txq->ac];
+	u32 window = READ_ONCE(sched->agg_wait_us);
+	ktime_t now, expires;
 
-	if (!sta || rtwsta->max_agg_wait <= 0)
+	if (!sta || rtwsta->max_agg_wait <= 0 || !window ||
+	    !READ_ONCE(rtwdev->txq_agg_wait_allowed)) {
+		rtw89_core_txq_agg_wait_end(rtwtxq, *frame_cnt);
 		return false;
+	}
 
-	if (rtwdev->stats.tx_tfc_lv <= RTW89_TFC_MID)
-		return false;
+	now = ktime_get();
 
 	if (*frame_cnt > 1) {
+		rtw89_core_txq_agg_wait_end(rtwtxq, *frame_cnt);
 		*frame_cnt -= 1;
 		*sched_txq = true;
-		*reinvoke = true;
-		rtwtxq->wait_cnt = 1;
+		rtwtxq->wait_start = now;
+		rtw89_core_txq_agg_wait_arm(sched, ktime_add_us(now, window));
 		return false;
 	}
 
-	if (*frame_cnt == 1 && rtwtxq->wait_cnt < rtwsta->max_agg_wait) {
-		*reinvoke = true;
-		rtwtxq->wait_cnt++;
-		return true;
+	if (*frame_cnt == 1) {
+		if (!rtwtxq->wait_start)
+			rtwtxq->wait_start = now;
+
+		expires = ktime_add_us(rtwtxq->wait_start, window);
+		if (ktime_before(now, expires)) {
+			rtw89_core_txq_agg_wait_arm(sched, expires);
+			return true;
+		}
 	}
 
-	rtwtxq->wait_cnt = 0;
+	rtw89_core_txq_agg_wait_end(rtwtxq, *frame_cnt);
 	return false;
 }
 
-static void rtw89_core_txq_schedule(struct rtw89_dev *rtwdev, u8 ac, bool *reinvoke)
+static void rtw89_core_txq_schedule(struct rtw89_dev *rtwdev, u8 ac, bool *reinvoke,
+				    struct rtw89_tx_kick_batch *kick)
 {
 	struct ieee80211_hw *hw = rtwdev->hw;
 	struct ieee80211_txq *txq;
@@ -2332,15 +2860,19 @@ static void rtw89_core_txq_schedule(struct rtw89_dev *rtwdev, u8 ac, bool *reinv
 		sched_txq = false;
 
 		ieee80211_txq_get_depth(txq, &frame_cnt, &byte_cnt);
-		if (rtw89_core_txq_agg_wait(rtwdev, txq, &frame_cnt, &sched_txq, reinvoke)) {
+		if (rtw89_core_txq_agg_wait(rtwdev, txq, &frame_cnt, &sched_txq)) {
 			ieee80211_return_txq(hw, txq, true);
 			continue;
 		}
 		frame_cnt = min_t(unsigned long, frame_cnt, tx_resource);
+		frame_cnt = rtw89_core_txq_airtime_limit(rtwdev, txq, frame_cnt,
+							 byte_cnt, reinvoke);
 		rtw89_core_txq_push(rtwdev, rtwtxq, frame_cnt, byte_cnt);
 		ieee80211_return_txq(hw, txq, sched_txq);
 		if (frame_cnt != 0)
-			rtw89_core_tx_kick_off(rtwdev, rtw89_core_get_qsel(rtwdev, txq->tid));
+			rtw89_core_tx_kick_defer(rtwdev, kick,
+						 rtw89_core_get_qsel(rtwdev, txq->tid),
+						 frame_cnt);
 
 		/* bound of tx_resource could get stuck due to burst traffic */
 		if (frame_cnt == tx_resource)
@@ -2358,27 +2890,88 @@ static void rtw89_ips_work(struct work_struct *work)
 	mutex_unlock(&rtwdev->mutex);
 }
 
-static void rtw89_core_txq_work(struct work_struct *w)
+void rtw89_core_txq_sched_queue(struct rtw89_dev *rtwdev, u8 ac)
+{
+	struct rtw89_txq_sched *sched = &rtwdev->txq_sched[ac];
+
+	/* keep the earliest request until the work picks it up */
+	atomic64_cmpxchg(&sched->queued_ns, 0, ktime_get_ns());
+	queue_work(rtwdev->txq_wq, &sched->work);
+}
+
+void rtw89_core_txq_sched_queue_all(struct rtw89_dev *rtwdev)
 {
-	struct rtw89_dev *rtwdev = container_of(w, struct rtw89_dev, txq_work);
-	bool reinvoke = false;
 	u8 ac;
 
 	for (ac = 0; ac < IEEE80211_NUM_ACS; ac++)
-		rtw89_core_txq_schedule(rtwdev, ac, &reinvoke);
+		rtw89_core_txq_sched_queue(rtwdev, ac);
+}
+
+void rtw89_core_txq_sched_flush(struct rtw89_dev *rtwdev)
+{
+	u8 ac;
+
+	for (ac = 0; ac < IEEE80211_NUM_ACS; ac++)
+		flush_work(&rtwdev->txq_sched[ac].work);
+}
+
+static int rtw89_core_txq_tfc_est_notify(struct notifier_block *nb,
+					  unsigned long event, void *data)
+{
+	struct rtw89_dev *rtwdev = container_of(nb, struct rtw89_dev,
+						txq_tfc_est_nb);
+	const struct rtw89_tfc_est_info *info = data;
+
+	if (event != RTW89_TFC_EST_EVT_LV_CHANGE)
+		return NOTIFY_DONE;
+
+	WRITE_ONCE(rtwdev->txq_agg_wait_allowed,
+		   info->tx_tfc_lv > RTW89_TFC_MID);
+
+	return NOTIFY_OK;
+}
+
+static void rtw89_core_txq_sched_latency(struct rtw89_txq_sched *sched)
+{
+	s64 queued_ns = atomic64_xchg(&sched->queued_ns, 0);
+	u32 lat_us;
+
+	if (!queued_ns)
+		return;
+
+	lat_us = div_u64(ktime_get_ns() - queued_ns, NSEC_PER_USEC);
+	sched->runs++;
+	sched->lat_sum_us += lat_us;
+	if (lat_us > sched->lat_max_us)
+		sched->lat_max_us = lat_us;
+}
+
+static void rtw89_core_txq_work(struct work_struct *w)
+{
+	struct rtw89_txq_sched *sched = container_of(w, struct rtw89_txq_sched,
+						     work);
+	struct rtw89_dev *rtwdev = sched->rtwdev;
+	struct rtw89_tx_kick_batch kick = {};
+	bool reinvoke = false;
+
+	rtw89_core_txq_sched_latency(sched);
+
+	rtw89_core_txq_schedule(rtwdev, sched->ac, &reinvoke, &kick);
+
+	rtw89_core_tx_kick_flush(rtwdev, &kick);
 
 	if (reinvoke) {
 		/* reinvoke to process the last frame */
-		mod_delayed_work(rtwdev->txq_wq, &rtwdev->txq_reinvoke_work, 1);
+		mod_delayed_work(rtwdev->txq_wq, &sched->reinvoke_work, 1);
 	}
 }
 
 static void rtw89_core_txq_reinvoke_work(struct work_struct *w)
 {
-	struct rtw89_dev *rtwdev = container_of(w, struct rtw89_dev,
-						txq_reinvoke_work.work);
+	struct rtw89_txq_sched *sched = container_of(w, struct rtw89_txq_sched,
+						     reinvoke_work.work);
 
-	queue_work(rtwdev->txq_wq, &rtwdev->txq_work);
+	rtw89_core_txq_sched_queue(sched->rtwdev, sched->ac);
 }
 
 static void rtw89_forbid_ba_work(struct work_struct *w)
@@ -2402,6 +2995,7 @@ static void rtw89_core_sta_pending_tx_iter(void *data,
 	struct rtw89_vif *rtwvif_target = data, *rtwvif = rtwsta->rtwvif;
 	struct rtw89_dev *rtwdev = rtwvif->rtwdev;
 	struct ieee80211_vif *vif = rtwvif_to_vif(rtwvif);
+	struct rtw89_tx_kick_batch kick = {};
 	struct sk_buff *skb, *tmp;
 	int qsel, ret;
 
@@ -2419,9 +3013,11 @@ static void rtw89_core_sta_pending_tx_iter(void *data,
 			rtw89_warn(rtwdev, "pending tx failed with %d\n", ret);
 			dev_kfree_skb_any(skb);
 		} else {
-			rtw89_core_tx_kick_off(rtwdev, qsel);
+			rtw89_core_tx_kick_defer(rtwdev, &kick, qsel, 1);
 		}
 	}
+
+	rtw89_core_tx_kick_flush(rtwdev, &kick);
 }
 
 static void rtw89_core_handle_sta_pending_tx(struct rtw89_dev *rtwdev,
@@ -2553,7 +3149,7 @@ void rtw89_roc_end(struct rtw89_dev *rtwdev, struct rtw89_vif *rtwvif)
 			tmp->offchan = false;
 
 	rtw89_core_handle_sta_pending_tx(rtwdev, rtwvif);
-	queue_work(rtwdev->txq_wq, &rtwdev->txq_work);
+	rtw89_core_txq_sched_queue_all(rtwdev);
 
 	if (hw->conf.flags & IEEE80211_CONF_IDLE)
 		ieee80211_queue_delayed_work(hw, &roc->roc_work,
@@ -2598,12 +3194,28 @@ static enum rtw89_tfc_lv rtw89_get_traffic_level(struct rtw89_dev *rtwdev,
 	return RTW89_TFC_ULTRA_LOW;
 }
 
+static void rtw89_traffic_stats_fold(struct rtw89_traffic_stats *stats)
+{
+	struct rtw89_traffic_stats_pcpu *last = &stats->pcpu_last;
+	struct rtw89_traffic_stats_pcpu sum;
+
+	rtw89_traffic_stats_sum(stats, &sum);
+
+	stats->tx_unicast = sum.tx_unicast - last->tx_unicast;
+	stats->rx_unicast = sum.rx_unicast - last->rx_unicast;
+	stats->tx_cnt = sum.tx_cnt - last->tx_cnt;
+	stats->rx_cnt = sum.rx_cnt - last->rx_cnt;
+	*last = sum;
+}
+
 static bool rtw89_traffic_stats_calc(struct rtw89_dev *rtwdev,
 				     struct rtw89_traffic_stats *stats)
 {
 	enum rtw89_tfc_lv tx_tfc_lv = stats->tx_tfc_lv;
 	enum rtw89_tfc_lv rx_tfc_lv = stats->rx_tfc_lv;
 
+	rtw89_traffic_stats_fold(stats);
+
 	stats->tx_throughput_raw = (u32)(stats->tx_unicast >> RTW89_TP_SHIFT);
 	stats->rx_throughput_raw = (u32)(stats->rx_unicast >> RTW89_TP_SHIFT);
 
@@ -2621,10 +3233,6 @@ static bool rtw89_traffic_stats_calc(struct rtw89_dev *rtwdev,
 	stats->rx_avg_len = stats->rx_cnt ?
 			    DIV_ROUND_DOWN_ULL(stats->rx_unicast, stats->rx_cnt) : 0;
 
-	stats->tx_unicast = 0;
-	stats->rx_unicast = 0;
-	stats->tx_cnt = 0;
-	stats->rx_cnt = 0;
 	stats->rx_tf_periodic = stats->rx_tf_acc;
 	stats->rx_tf_acc = 0;
 
@@ -2634,6 +3242,113 @@ static bool rtw89_traffic_stats_calc(struct rtw89_dev *rtwdev,
 	return false;
 }
 
+static u32 rtw89_tfc_est_tp(struct ewma_tfc_est *ewma, unsigned long bytes,
+			    u64 elapsed_us)
+{
+	/* bits per us is Mbps */
+	u32 tp = div64_u64((u64)bytes * 8, elapsed_us);
+
+	ewma_tfc_est_add(ewma, tp);
+
+	return max_t(u32, tp, ewma_tfc_est_read(ewma));
+}
+
+static enum rtw89_tfc_lv rtw89_tfc_est_level(struct rtw89_dev *rtwdev,
+					     u32 throughput, unsigned long cnt,
+					     u64 elapsed_us)
+{
+	/* scale packet count to the 2s track period of the level thresholds */
+	u64 cnt_2s = div64_u64((u64)cnt * 2 * USEC_PER_SEC, elapsed_us);
+
+	return rtw89_get_traffic_level(rtwdev, throughput, cnt_2s);
+}
+
+static void rtw89_tfc_est_work(struct work_struct *work)
+{
+	struct rtw89_dev *rtwdev = container_of(work, struct rtw89_dev,
+						tfc_est.work.work);
+	struct rtw89_tfc_est *est = &rtwdev->tfc_est;
+	struct rtw89_tfc_est_info info;
+	struct rtw89_traffic_stats_pcpu sum;
+	ktime_t now = ktime_get();
+	u64 elapsed_us;
+	bool changed;
+
+	rtw89_traffic_stats_sum(&rtwdev->stats, &sum);
+	elapsed_us = ktime_us_delta(now, est->last_time);
+	if (!elapsed_us)
+		goto rearm;
+
+	info.tx_throughput = rtw89_tfc_est_tp(&est->tx_ewma_tp,
+					      sum.tx_unicast - est->last.tx_unicast,
+					      elapsed_us);
+	info.rx_throughput = rtw89_tfc_est_tp(&est->rx_ewma_tp,
+					      sum.rx_unicast - est->last.rx_unicast,
+					      elapsed_us);
+	info.tx_tfc_lv = rtw89_tfc_est_level(rtwdev, info.tx_throughput,
+					     sum.tx_cnt - est->last.tx_cnt,
+					     elapsed_us);
+	info.rx_tfc_lv = rtw89_tfc_est_level(rtwdev, info.rx_throughput,
+					     sum.rx_cnt - est->last.rx_cnt,
+					     elapsed_us);
+	est->last = sum;
+	est->last_time = now;
+
+	changed = info.tx_tfc_lv != est->info.tx_tfc_lv ||
+		  info.rx_tfc_lv != est->info.rx_tfc_lv;
+
+	WRITE_ONCE(est->info.tx_throughput, info.tx_throughput);
+	WRITE_ONCE(est->info.rx_throughput, info.rx_throughput);
+	WRITE_ONCE(est->info.tx_tfc_lv, info.tx_tfc_lv);
+	WRITE_ONCE(est->info.rx_tfc_lv, info.rx_tfc_lv);
+
+	if (changed)
+		blocking_notifier_call_chain(&est->notifier,
+					     RTW89_TFC_EST_EVT_LV_CHANGE, &info);
+
+	if (info.tx_tfc_lv == RTW89_TFC_IDLE &&
+	    info.rx_tfc_lv == RTW89_TFC_IDLE) {
+		/* rtw89_tfc_est_kick() restarts sampling on next traffic */
+		clear_bit_unlock(RTW89_FLAG_TFC_EST_RUNNING, rtwdev->flags);
+		return;
+	}
+
+rearm:
+	queue_delayed_work(rtwdev->txq_wq, &est->work,
+			   msecs_to_jiffies(RTW89_TFC_EST_PERIOD_MS));
+}
+
+static void rtw89_tfc_est_start(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_tfc_est *est = &rtwdev->tfc_est;
+
+	rtw89_traffic_stats_sum(&rtwdev->stats, &est->last);
+	est->last_time = ktime_get();
+	ewma_tfc_est_init(&est->tx_ewma_tp);
+	ewma_tfc_est_init(&est->rx_ewma_tp);
+	memset(&est->info, 0, sizeof(est->info));
+	blocking_notifier_call_chain(&est->notifier,
+				     RTW89_TFC_EST_EVT_LV_CHANGE, &est->info);
+
+	set_bit(RTW89_FLAG_TFC_EST_RUNNING, rtwdev->flags);
+	queue_delayed_work(rtwdev->txq_wq, &est->work,
+			   msecs_to_jiffies(RTW89_TFC_EST_PERIOD_MS));
+}
+
+int rtw89_tfc_est_register_notifier(struct rtw89_dev *rtwdev,
+				    struct notifier_block *nb)
+{
+	return blocking_notifier_chain_register(&rtwdev->tfc_est.notifier, nb);
+}
+EXPORT_SYMBOL(rtw89_tfc_est_register_notifier);
+
+int rtw89_tfc_est_unregister_notifier(struct rtw89_dev *rtwdev,
+				      struct notifier_block *nb)
+{
+	return blocking_notifier_chain_unregister(&rtwdev->tfc_est.notifier, nb);
+}
+EXPORT_SYMBOL(rtw89_tfc_est_unregister_notifier);
+
 static bool rtw89_traffic_stats_track(struct rtw89_dev *rtwdev)
 {
 	struct rtw89_vif *rtwvif;
@@ -2671,21 +3386,161 @@ static void rtw89_enter_lps_track(struct rtw89_dev *rtwdev)
 		rtw89_vif_enter_lps(rtwdev, rtwvif);
 }
 
-void rtw89_traffic_stats_init(struct rtw89_dev *rtwdev,
-			      struct rtw89_traffic_stats *stats)
+int rtw89_traffic_stats_init(struct rtw89_dev *rtwdev,
+			     struct rtw89_traffic_stats *stats)
 {
+	if (!stats->pcpu) {
+		stats->pcpu = alloc_percpu(struct rtw89_traffic_stats_pcpu);
+		if (!stats->pcpu)
+			return -ENOMEM;
+	}
+
+	/* start counting from the current per-CPU totals */
+	rtw89_traffic_stats_fold(stats);
 	stats->tx_unicast = 0;
 	stats->rx_unicast = 0;
 	stats->tx_cnt = 0;
 	stats->rx_cnt = 0;
 	ewma_tp_init(&stats->tx_ewma_tp);
 	ewma_tp_init(&stats->rx_ewma_tp);
+
+	return 0;
+}
+
+void rtw89_traffic_stats_deinit(struct rtw89_dev *rtwdev,
+				struct rtw89_traffic_stats *stats)
+{
+	free_percpu(stats->pcpu);
+	stats->pcpu = NULL;
+}
+
+struct rtw89_dm_task_desc {
+	const char *name;
+	void (*track)(struct rtw89_dev *rtwdev);
+	/* tasks whose results this one uses, run first if it is due */
+	u32 prereqs;
+};
+
+/* in the order to run, so prerequisites come before their users */
+static const struct rtw89_dm_task_desc rtw89_dm_task_descs[RTW89_DM_TASK_NUM] = {
+	[RTW89_DM_TASK_BF_MONITOR] = {"bf_monitor", rtw89_mac_bf_monitor_track},
+	[RTW89_DM_TASK_PHY_STAT] = {"phy_stat", rtw89_phy_stat_track},
+	[RTW89_DM_TASK_ENV_MONITOR] = {"env_monitor", rtw89_phy_env_monitor_track},
+	[RTW89_DM_TASK_DIG] = {"dig", rtw89_phy_dig,
+			       BIT(RTW89_DM_TASK_PHY_STAT) |
+			       BIT(RTW89_DM_TASK_ENV_MONITOR)},
+	[RTW89_DM_TASK_RFK] = {"rfk", rtw89_chip_rfk_track},
+	[RTW89_DM_TASK_RA] = {"ra", rtw89_phy_ra_update,
+			      BIT(RTW89_DM_TASK_PHY_STAT)},
+	[RTW89_DM_TASK_CFO] = {"cfo", rtw89_phy_cfo_track},
+	[RTW89_DM_TASK_TX_PATH_DIV] = {"tx_path_div", rtw89_phy_tx_path_div_track},
+	[RTW89_DM_TASK_ANTDIV] = {"antdiv", rtw89_phy_antdiv_track},
+	[RTW89_DM_TASK_UL_TB] = {"ul_tb", rtw89_phy_ul_tb_ctrl_track},
+};
+
+const char *rtw89_dm_task_name(enum rtw89_dm_task_id id)
+{
+	if (id >= RTW89_DM_TASK_NUM)
+		return NULL;
+
+	return rtw89_dm_task_descs[id].name;
+}
+
+static bool rtw89_dm_task_allowed(struct rtw89_dev *rtwdev)
+{
+	lockdep_assert_held(&rtwdev->mutex);
+
+	return test_bit(RTW89_FLAG_RUNNING, rtwdev->flags) && !rtwdev->scanning;
+}
+
+static void rtw89_dm_task_run(struct rtw89_dev *rtwdev,
+			      enum rtw89_dm_task_id id)
+{
+	struct rtw89_dm_task *task = &rtwdev->dm_tasks[id];
+	u64 start = ktime_get_ns();
+	u32 run_us;
+
+	lockdep_assert_held(&rtwdev->mutex);
+
+	rtw89_dm_task_descs[id].track(rtwdev);
+
+	run_us = div_u64(ktime_get_ns() - start, NSEC_PER_USEC);
+	task->last_run = jiffies;
+	task->runs++;
+	task->run_sum_us += run_us;
+	if (run_us > task->run_max_us)
+		task->run_max_us = run_us;
+}
+
+static void rtw89_dm_work_kick(struct rtw89_dev *rtwdev)
+{
+	u32 period, min_period = RTW89_DM_TASK_PERIOD_MAX_MS;
+	enum rtw89_dm_task_id id;
+
+	if (test_bit(RTW89_FLAG_FORBIDDEN_TRACK_WROK, rtwdev->flags))
+		return;
+
+	for (id = 0; id < RTW89_DM_TASK_NUM; id++) {
+		period = READ_ONCE(rtwdev->dm_tasks[id].period_ms);
+		min_period = min(min_period, period);
+	}
+
+	/* all tasks are run by track_work */
+	if (min_period >= RTW89_DM_TASK_PERIOD_MAX_MS)
+		return;
+
+	ieee80211_queue_delayed_work(rtwdev->hw, &rtwdev->dm_work,
+				     msecs_to_jiffies(min_period));
+}
+
+static void rtw89_dm_work(struct work_struct *work)
+{
+	struct rtw89_dev *rtwdev = container_of(work, struct rtw89_dev,
+						dm_work.work);
+	struct rtw89_dm_task *task;
+	enum rtw89_dm_task_id id;
+	u32 due = 0;
+	u32 period;
+
+	if (test_bit(RTW89_FLAG_FORBIDDEN_TRACK_WROK, rtwdev->flags))
+		return;
+
+	for (id = 0; id < RTW89_DM_TASK_NUM; id++) {
+		task = &rtwdev->dm_tasks[id];
+		period = READ_ONCE(task->period_ms);
+		if (period >= RTW89_DM_TASK_PERIOD_MAX_MS ||
+		    time_before(jiffies, task->last_run + msecs_to_jiffies(period)))
+			continue;
+
+		due |= BIT(id) | rtw89_dm_task_descs[id].prereqs;
+	}
+
+	for (id = 0; id < RTW89_DM_TASK_NUM; id++) {
+		if (!(due & BIT(id)))
+			continue;
+
+		task = &rtwdev->dm_tasks[id];
+		mutex_lock(&rtwdev->mutex);
+		/* don't leave LPS for a task; track_work runs it when awake */
+		if (!rtw89_dm_task_allowed(rtwdev) ||
+		    test_bit(RTW89_FLAG_LEISURE_PS, rtwdev->flags))
+			task->skipped++;
+		else
+			rtw89_dm_task_run(rtwdev, id);
+		mutex_unlock(&rtwdev->mutex);
+	}
+
+	mutex_lock(&rtwdev->mutex);
+	if (test_bit(RTW89_FLAG_RUNNING, rtwdev->flags))
+		rtw89_dm_work_kick(rtwdev);
+	mutex_unlock(&rtwdev->mutex);
 }
 
 static void rtw89_track_work(struct work_struct *work)
 {
 	struct rtw89_dev *rtwdev = container_of(work, struct rtw89_dev,
 						track_work.work);
+	enum rtw89_dm_task_id id;
 	bool tfc_changed;
 
 	if (test_bit(RTW89_FLAG_FORBIDDEN_TRACK_WROK, rtwdev->flags))
@@ -2709,20 +3564,27 @@ static void rtw89_track_work(struct work_struct *work)
 		rtw89_hci_recalc_int_mit(rtwdev);
 		rtw89_btc_ntfy_wl_sta(rtwdev);
 	}
-	rtw89_mac_bf_monitor_track(rtwdev);
-	rtw89_phy_stat_track(rtwdev);
-	rtw89_phy_env_monitor_track(rtwdev);
-	rtw89_phy_dig(rtwdev);
-	rtw89_chip_rfk_track(rtwdev);
-	rtw89_phy_ra_update(rtwdev);
-	rtw89_phy_cfo_track(rtwdev);
-	rtw89_phy_tx_path_div_track(rtwdev);
-	rtw89_phy_antdiv_track(rtwdev);
-	rtw89_phy_ul_tb_ctrl_track(rtwdev);
+	rtw89_hci_recalc_link_pm(rtwdev);
+	mutex_unlock(&rtwdev->mutex);
+
+	for (id = 0; id < RTW89_DM_TASK_NUM; id++) {
+		mutex_lock(&rtwdev->mutex);
+		if (!rtw89_dm_task_allowed(rtwdev))
+			goto out;
+		rtw89_leave_lps(rtwdev);
+		rtw89_dm_task_run(rtwdev, id);
+		mutex_unlock(&rtwdev->mutex);
+	}
+
+	mutex_lock(&rtwdev->mutex);
+	if (!rtw89_dm_task_allowed(rtwdev))
+		goto out;
 
 	if (rtwdev->lps_enabled && !rtwdev->btc.lps)
 		rtw89_enter_lps_track(rtwdev);
 
+	rtw89_dm_work_kick(rtwdev);
+
 out:
 	mutex_unlock(&rtwdev->mutex);
 }
@@ -2889,9 +3751,17 @@ int rtw89_core_sta_add(struct rtw89_dev *rtwdev,
 	rtwsta->rtwdev = rtwdev;
 	rtwsta->rtwvif = rtwvif;
 	rtwsta->prev_rssi = 0;
+	for (i = 0; i < IEEE80211_NUM_ACS; i++)
+		atomic_set(&rtwsta->airtime_inflight[i], 0);
 	INIT_LIST_HEAD(&rtwsta->ba_cam_list);
 	skb_queue_head_init(&rtwsta->roc_queue);
 
+	spin_lock_init(&rtwsta->tx_desc_tmpl_lock);
+	for (i = 0; i < RTW89_TX_DESC_TMPL_NUM; i++) {
+		seqcount_init(&rtwsta->tx_desc_tmpl[i].seq);
+		rtwsta->tx_desc_tmpl[i].gen = 0;
+	}
+
 	for (i = 0; i < ARRAY_SIZE(sta->txq); i++)
 		rtw89_core_txq_init(rtwdev, sta->txq[i]);
 
@@ -2935,6 +3805,8 @@ int rtw89_core_sta_add(struct rtw89_dev *rtwdev,
 		}
 	}
 
+	rcu_assign_pointer(rtwdev->sta_on_mac_id[rtwsta->mac_id], rtwsta);
+
 	return 0;
 }
 
@@ -3083,6 +3955,14 @@ int rtw89_core_sta_remove(struct rtw89_dev *rtwdev,
 	struct rtw89_sta *rtwsta = (struct rtw89_sta *)sta->drv_priv;
 	int ret;
 
+	/* mac80211 frees the station right after this returns, so wait for
+	 * RX paths that may have looked it up by mac_id.
+	 */
+	if (rcu_access_pointer(rtwdev->sta_on_mac_id[rtwsta->mac_id]) == rtwsta) {
+		RCU_INIT_POINTER(rtwdev->sta_on_mac_id[rtwsta->mac_id], NULL);
+		synchronize_rcu();
+	}
+
 	if (vif->type == NL80211_IFTYPE_STATION && !sta->tdls) {
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 16, 0)
 		rtw89_reg_6ghz_power_recalc(rtwdev, rtwvif, false);
@@ -3470,14 +4350,35 @@ static void rtw89_core_clr_supported_band(struct rtw89_dev *rtwdev)
 	hw->wiphy->bands[NL80211_BAND_6GHZ] = NULL;
 }
 
+static enum hrtimer_restart rtw89_core_ppdu_sts_flush_timer(struct hrtimer *timer)
+{
+	struct rtw89_dev *rtwdev = container_of(timer, struct rtw89_dev,
+						ppdu_sts.flush_timer);
+
+	/* queues are owned by RX NAPI, which flushes expired ones */
+	WRITE_ONCE(rtwdev->ppdu_sts.napi_by_timer, true);
+	napi_schedule(&rtwdev->napi);
+
+	return HRTIMER_NORESTART;
+}
+
 static void rtw89_core_ppdu_sts_init(struct rtw89_dev *rtwdev)
 {
+	struct rtw89_ppdu_sts_info *ppdu_sts = &rtwdev->ppdu_sts;
 	int i;
 
 	for (i = 0; i < RTW89_PHY_MAX; i++)
-		skb_queue_head_init(&rtwdev->ppdu_sts.rx_queue[i]);
+		skb_queue_head_init(&ppdu_sts->rx_queue[i]);
 	for (i = 0; i < RTW89_PHY_MAX; i++)
-		rtwdev->ppdu_sts.curr_rx_ppdu_cnt[i] = U8_MAX;
+		ppdu_sts->curr_rx_ppdu_cnt[i] = U8_MAX;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+	hrtimer_setup(&ppdu_sts->flush_timer, rtw89_core_ppdu_sts_flush_timer,
+		      CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+#else
+	hrtimer_init(&ppdu_sts->flush_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	ppdu_sts->flush_timer.function = rtw89_core_ppdu_sts_flush_timer;
+#endif
 }
 
 void rtw89_core_update_beacon_work(struct work_struct *work)
@@ -3571,6 +4472,7 @@ int rtw89_core_start(struct rtw89_dev *rtwdev)
 
 	ieee80211_queue_delayed_work(rtwdev->hw, &rtwdev->track_work,
 				     RTW89_TRACK_WORK_PERIOD);
+	rtw89_tfc_est_start(rtwdev);
 
 	set_bit(RTW89_FLAG_RUNNING, rtwdev->flags);
 
@@ -3584,6 +4486,7 @@ int rtw89_core_start(struct rtw89_dev *rtwdev)
 void rtw89_core_stop(struct rtw89_dev *rtwdev)
 {
 	struct rtw89_btc *btc = &rtwdev->btc;
+	u8 ac;
 
 	/* Prvent to stop twice; enter_ips and ops_stop */
 	if (!test_bit(RTW89_FLAG_RUNNING, rtwdev->flags))
@@ -3601,8 +4504,14 @@ void rtw89_core_stop(struct rtw89_dev *rtwdev)
 	cancel_work_sync(&btc->arp_notify_work);
 	cancel_work_sync(&btc->dhcp_notify_work);
 	cancel_work_sync(&btc->icmp_notify_work);
-	cancel_delayed_work_sync(&rtwdev->txq_reinvoke_work);
+	for (ac = 0; ac < IEEE80211_NUM_ACS; ac++) {
+		cancel_delayed_work_sync(&rtwdev->txq_sched[ac].reinvoke_work);
+		hrtimer_cancel(&rtwdev->txq_sched[ac].agg_wait_timer);
+	}
 	cancel_delayed_work_sync(&rtwdev->track_work);
+	cancel_delayed_work_sync(&rtwdev->dm_work);
+	cancel_delayed_work_sync(&rtwdev->tfc_est.work);
+	clear_bit(RTW89_FLAG_TFC_EST_RUNNING, rtwdev->flags);
 	cancel_delayed_work_sync(&rtwdev->coex_act1_work);
 	cancel_delayed_work_sync(&rtwdev->coex_bt_devinfo_work);
 	cancel_delayed_work_sync(&rtwdev->coex_rfk_chk_work);
@@ -3624,21 +4533,52 @@ void rtw89_core_stop(struct rtw89_dev *rtwdev)
 int rtw89_core_init(struct rtw89_dev *rtwdev)
 {
 	struct rtw89_btc *btc = &rtwdev->btc;
+	enum rtw89_dm_task_id id;
 	u8 band;
+	u8 ac;
+	int ret;
 
 	INIT_LIST_HEAD(&rtwdev->ba_list);
 	INIT_LIST_HEAD(&rtwdev->forbid_ba_list);
 	INIT_LIST_HEAD(&rtwdev->rtwvifs_list);
 	INIT_LIST_HEAD(&rtwdev->early_h2c_list);
+	INIT_LIST_HEAD(&rtwdev->rx_batch_list);
+	/* templates of new stations are zeroed, so start from a valid one */
+	atomic_set(&rtwdev->tx_desc_tmpl_gen, 1);
 	for (band = NL80211_BAND_2GHZ; band < NUM_NL80211_BANDS; band++) {
 		if (!(rtwdev->chip->support_bands & BIT(band)))
 			continue;
 		INIT_LIST_HEAD(&rtwdev->scan_info.pkt_list[band]);
 	}
 	INIT_WORK(&rtwdev->ba_work, rtw89_core_ba_work);
-	INIT_WORK(&rtwdev->txq_work, rtw89_core_txq_work);
-	INIT_DELAYED_WORK(&rtwdev->txq_reinvoke_work, rtw89_core_txq_reinvoke_work);
+	for (ac = 0; ac < IEEE80211_NUM_ACS; ac++) {
+		struct rtw89_txq_sched *sched = &rtwdev->txq_sched[ac];
+
+		sched->rtwdev = rtwdev;
+		sched->ac = ac;
+		INIT_WORK(&sched->work, rtw89_core_txq_work);
+		INIT_DELAYED_WORK(&sched->reinvoke_work, rtw89_core_txq_reinvoke_work);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+		hrtimer_setup(&sched->agg_wait_timer, rtw89_core_agg_wait_timer,
+			      CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+#else
+		hrtimer_init(&sched->agg_wait_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+		sched->agg_wait_timer.function = rtw89_core_agg_wait_timer;
+#endif
+		atomic64_set(&sched->queued_ns, 0);
+	}
+	rtwdev->txq_sched[IEEE80211_AC_VO].agg_wait_us = 0;
+	rtwdev->txq_sched[IEEE80211_AC_VI].agg_wait_us = 200;
+	rtwdev->txq_sched[IEEE80211_AC_BE].agg_wait_us = 500;
+	rtwdev->txq_sched[IEEE80211_AC_BK].agg_wait_us = 1000;
 	INIT_DELAYED_WORK(&rtwdev->track_work, rtw89_track_work);
+	INIT_DELAYED_WORK(&rtwdev->dm_work, rtw89_dm_work);
+	for (id = 0; id < RTW89_DM_TASK_NUM; id++)
+		rtwdev->dm_tasks[id].period_ms = RTW89_DM_TASK_PERIOD_MAX_MS;
+	INIT_DELAYED_WORK(&rtwdev->tfc_est.work, rtw89_tfc_est_work);
+	BLOCKING_INIT_NOTIFIER_HEAD(&rtwdev->tfc_est.notifier);
+	rtwdev->txq_tfc_est_nb.notifier_call = rtw89_core_txq_tfc_est_notify;
+	rtw89_tfc_est_register_notifier(rtwdev, &rtwdev->txq_tfc_est_nb);
 	INIT_DELAYED_WORK(&rtwdev->coex_act1_work, rtw89_coex_act1_work);
 	INIT_DELAYED_WORK(&rtwdev->coex_bt_devinfo_work, rtw89_coex_bt_devinfo_work);
 	INIT_DELAYED_WORK(&rtwdev->coex_rfk_chk_work, rtw89_coex_rfk_chk_work);
@@ -3664,7 +4604,11 @@ int rtw89_core_init(struct rtw89_dev *rtwdev)
 
 	skb_queue_head_init(&rtwdev->c2h_queue);
 	rtw89_core_ppdu_sts_init(rtwdev);
-	rtw89_traffic_stats_init(rtwdev, &rtwdev->stats);
+	ret = rtw89_traffic_stats_init(rtwdev, &rtwdev->stats);
+	if (ret) {
+		destroy_workqueue(rtwdev->txq_wq);
+		return ret;
+	}
 
 	rtwdev->hal.rx_fltr = DEFAULT_AX_RX_FLTR;
 
@@ -3690,6 +4634,8 @@ void rtw89_core_deinit(struct rtw89_dev *rtwdev)
 	rtw89_unload_firmware(rtwdev);
 	rtw89_fw_free_all_early_h2c(rtwdev);
 
+	rtw89_tfc_est_unregister_notifier(rtwdev, &rtwdev->txq_tfc_est_nb);
+	rtw89_traffic_stats_deinit(rtwdev, &rtwdev->stats);
 	destroy_workqueue(rtwdev->txq_wq);
 	mutex_destroy(&rtwdev->rf_mutex);
 	mutex_destroy(&rtwdev->mutex);
@@ -3731,6 +4677,7 @@ void rtw89_core_scan_complete(struct rtw89_dev *rtwdev,
 	rtw89_phy_config_edcca(rtwdev, false);
 
 	rtwdev->scanning = false;
+	rtw89_hci_recalc_int_mit(rtwdev);
 	rtwdev->dig.bypass_dig = true;
 	if (hw_scan && (rtwdev->hw->conf.flags & IEEE80211_CONF_IDLE))
 		ieee80211_queue_work(rtwdev->hw, &rtwdev->ips_work);
@@ -3936,6 +4883,10 @@ static int rtw89_core_register_hw(struct rtw89_dev *rtwdev)
 	hw->wiphy->max_remain_on_channel_duration = 1000;
 
 	wiphy_ext_feature_set(hw->wiphy, NL80211_EXT_FEATURE_CAN_REPLACE_PTK0);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 10, 0)
+	wiphy_ext_feature_set(hw->wiphy, NL80211_EXT_FEATURE_AIRTIME_FAIRNESS);
+	wiphy_ext_feature_set(hw->wiphy, NL80211_EXT_FEATURE_AQL);
+#endif
 
 	ret = rtw89_core_set_supported_band(rtwdev);
 	if (ret) {
@@ -8,6 +8,7 @@
 #include <linux/average.h>
 #include <linux/bitfield.h>
 #include <linux/firmware.h>
+#include <linux/indirect_call_wrapper.h>
 #include <linux/iopoll.h>
 #include <linux/workqueue.h>
 #include <net/mac80211.h>
@@ -845,6 +846,23 @@ struct rtw89_tx_desc_info {
 	bool er_cap;
 };
 
+/* Fields of TX descriptor that only depend on the station and TID, which
+ * are built once and reused until rtwdev->tx_desc_tmpl_gen is bumped.
+ * Per-frame fields (size, sequence, security IV, HTC, BK) are never cached.
+ * Readers retry on seq, and writers hold rtwsta->tx_desc_tmpl_lock, since
+ * TX of mac80211 and TXQ works can build the same template concurrently.
+ */
+struct rtw89_tx_desc_tmpl {
+	seqcount_t seq;
+	u32 gen;
+	struct ieee80211_key_conf *key;
+	struct rtw89_tx_desc_info desc_info;
+	u8 ampdu_num;
+	u8 ampdu_density;
+};
+
+#define RTW89_TX_DESC_TMPL_NUM	(IEEE80211_QOS_CTL_TAG1D_MASK + 1)
+
 struct rtw89_core_tx_request {
 	enum rtw89_core_tx_type tx_type;
 
@@ -852,12 +870,21 @@ struct rtw89_core_tx_request {
 	struct ieee80211_vif *vif;
 	struct ieee80211_sta *sta;
 	struct rtw89_tx_desc_info desc_info;
+	/* A-MPDU parameters read along with the descriptor template */
+	bool desc_tmpl_hit;
+	u8 tmpl_ampdu_num;
+	u8 tmpl_ampdu_density;
 };
 
 struct rtw89_txq {
 	struct list_head list;
 	unsigned long flags;
-	int wait_cnt;
+
+	/* aggregation wait of the last frame, see rtw89_core_txq_agg_wait() */
+	ktime_t wait_start;
+	u32 wait_cnt;
+	u32 wait_expired;
+	u64 wait_gained;
 };
 
 struct rtw89_mac_ax_gnt {
@@ -1018,8 +1045,22 @@ enum rtw89_tfc_lv {
 #define RTW89_TP_SHIFT 18 /* bytes/2s --> Mbps */
 DECLARE_EWMA(tp, 10, 2);
 
+/* Free-running counters updated on the local CPU by TX/RX paths. They are
+ * unsigned long so they can be read without tearing; deltas of one track
+ * period never wrap.
+ */
+struct rtw89_traffic_stats_pcpu {
+	unsigned long tx_unicast;
+	unsigned long rx_unicast;
+	unsigned long tx_cnt;
+	unsigned long rx_cnt;
+};
+
 struct rtw89_traffic_stats {
-	/* units in bytes */
+	struct rtw89_traffic_stats_pcpu __percpu *pcpu;
+	struct rtw89_traffic_stats_pcpu pcpu_last;
+
+	/* units in bytes, folded from pcpu per track period */
 	u64 tx_unicast;
 	u64 rx_unicast;
 	u32 tx_avg_len;
@@ -1047,6 +1088,37 @@ struct rtw89_traffic_stats {
 	u16 rx_rate;
 };
 
+#define RTW89_TFC_EST_PERIOD_MS 100
+DECLARE_EWMA(tfc_est, 10, 4);
+
+enum rtw89_tfc_est_event {
+	RTW89_TFC_EST_EVT_LV_CHANGE,
+};
+
+struct rtw89_tfc_est_info {
+	/* units in Mbps */
+	u32 tx_throughput;
+	u32 rx_throughput;
+	enum rtw89_tfc_lv tx_tfc_lv;
+	enum rtw89_tfc_lv rx_tfc_lv;
+};
+
+/* Traffic estimate of short period, sampled from the per-CPU counters of
+ * rtwdev->stats without holding rtwdev->mutex. Rising traffic is followed
+ * at once and falling traffic through an EWMA, so bursts show up within a
+ * period. Subscribers are notified when a level changes. Sampling stops
+ * when traffic is idle, and the TX/RX path kicks it again.
+ */
+struct rtw89_tfc_est {
+	struct delayed_work work;
+	struct blocking_notifier_head notifier;
+	struct rtw89_traffic_stats_pcpu last;
+	ktime_t last_time;
+	struct ewma_tfc_est tx_ewma_tp;
+	struct ewma_tfc_est rx_ewma_tp;
+	struct rtw89_tfc_est_info info;
+};
+
 struct rtw89_btc_statistic {
 	u8 rssi; /* 0%~110% (dBm = rssi -110) */
 	struct rtw89_traffic_stats traffic;
@@ -2625,6 +2697,11 @@ struct rtw89_sta {
 	struct ewma_evm evm_min[RF_PATH_MAX];
 	struct ewma_evm evm_max[RF_PATH_MAX];
 	struct rtw89_ampdu_params ampdu_params[IEEE80211_NUM_TIDS];
+	/* serialize writers of tx_desc_tmpl */
+	spinlock_t tx_desc_tmpl_lock;
+	struct rtw89_tx_desc_tmpl tx_desc_tmpl[RTW89_TX_DESC_TMPL_NUM];
+	/* us, AQL estimate of frames in hardware */
+	atomic_t airtime_inflight[IEEE80211_NUM_ACS];
 	struct ieee80211_rx_status rx_status;
 	u16 rx_hw_rate;
 	__le32 htc_template;
@@ -2686,6 +2763,8 @@ struct rtw89_roc {
 };
 
 #define RTW89_P2P_MAX_NOA_NUM 2
+#define RTW89_BCN_RSSI_OFLD_INTVL msecs_to_jiffies(500)
+#define RTW89_BCN_RSSI_OFLD_DELTA (3 << RSSI_FACTOR)
 
 struct rtw89_vif {
 	struct list_head list;
@@ -2720,6 +2799,8 @@ struct rtw89_vif {
 	bool dyn_tb_bedge_en;
 	u8 def_tri_idx;
 	u32 tdls_peer;
+	unsigned long bcn_rssi_ofld_time;
+	u8 bcn_rssi_ofld;
 	struct work_struct update_beacon_work;
 	struct rtw89_addr_cam_entry addr_cam;
 	struct rtw89_bssid_cam_entry bssid_cam;
@@ -2746,6 +2827,7 @@ struct rtw89_hci_ops {
 	void (*pause)(struct rtw89_dev *rtwdev, bool pause);
 	void (*switch_mode)(struct rtw89_dev *rtwdev, bool low_power);
 	void (*recalc_int_mit)(struct rtw89_dev *rtwdev);
+	void (*recalc_link_pm)(struct rtw89_dev *rtwdev);
 
 	u8 (*read8)(struct rtw89_dev *rtwdev, u32 addr);
 	u16 (*read16)(struct rtw89_dev *rtwdev, u32 addr);
@@ -2762,6 +2844,8 @@ struct rtw89_hci_ops {
 	int (*mac_lv1_rcvy)(struct rtw89_dev *rtwdev, enum rtw89_lv1_rcvy_step step);
 	void (*dump_err_status)(struct rtw89_dev *rtwdev);
 	int (*napi_poll)(struct napi_struct *napi, int budget);
+	/* optional, poll TX release by another NAPI than RX */
+	int (*napi_poll_tx)(struct napi_struct *napi, int budget);
 
 	/* Deal with locks inside recovery_start and recovery_complete callbacks
 	 * by hci instance, and handle things which need to consider under SER.
@@ -2779,6 +2863,9 @@ struct rtw89_hci_ops {
 	void (*disable_intr)(struct rtw89_dev *rtwdev);
 	void (*enable_intr)(struct rtw89_dev *rtwdev);
 	int (*rst_bdram)(struct rtw89_dev *rtwdev);
+	/* optional, reallocate DMA rings while down */
+	int (*resize_rings)(struct rtw89_dev *rtwdev, u32 txbd_num,
+			    u32 rxbd_num, u32 txwd_num);
 };
 
 struct rtw89_hci_info {
@@ -3526,6 +3613,7 @@ enum rtw89_flags {
 	RTW89_FLAG_WOWLAN,
 	RTW89_FLAG_FORBIDDEN_TRACK_WROK,
 	RTW89_FLAG_CHANGING_INTERFACE,
+	RTW89_FLAG_TFC_EST_RUNNING,
 
 	NUM_OF_RTW89_FLAGS,
 };
@@ -4000,9 +4088,81 @@ struct rtw89_lps_parm {
 	u8 lastrpwm; /* enum rtw89_last_rpwm_mode */
 };
 
+#define RTW89_DM_TASK_PERIOD_MIN_MS 100
+#define RTW89_DM_TASK_PERIOD_MAX_MS 2000 /* RTW89_TRACK_WORK_PERIOD */
+
+enum rtw89_dm_task_id {
+	RTW89_DM_TASK_BF_MONITOR,
+	RTW89_DM_TASK_PHY_STAT,
+	RTW89_DM_TASK_ENV_MONITOR,
+	RTW89_DM_TASK_DIG,
+	RTW89_DM_TASK_RFK,
+	RTW89_DM_TASK_RA,
+	RTW89_DM_TASK_CFO,
+	RTW89_DM_TASK_TX_PATH_DIV,
+	RTW89_DM_TASK_ANTDIV,
+	RTW89_DM_TASK_UL_TB,
+
+	RTW89_DM_TASK_NUM,
+};
+
+/* A dynamic mechanism run by track_work every track period, and also by
+ * dm_work in between if its period is shorter, together with the tasks it
+ * takes results from. Each run takes rtwdev->mutex on its own, so other
+ * control paths can go in between.
+ */
+struct rtw89_dm_task {
+	u32 period_ms;
+	unsigned long last_run;
+
+	u64 runs;
+	u64 run_sum_us;
+	u32 run_max_us;
+	/* runs of dm_work skipped for LPS or scanning */
+	u32 skipped;
+};
+
+/* TX scheduling of an AC runs in its own work, so a long BE backlog doesn't
+ * delay VO/VI, which go to separate DMA channels anyway.
+ */
+struct rtw89_txq_sched {
+	struct rtw89_dev *rtwdev;
+	u8 ac;
+	struct work_struct work;
+	struct delayed_work reinvoke_work;
+
+	/* window to hold the last frame of a TXQ for aggregation */
+	u32 agg_wait_us;
+	struct hrtimer agg_wait_timer;
+
+	/* earliest time the work is queued since last run, 0 if none */
+	atomic64_t queued_ns;
+	/* scheduling latency, only updated by the work itself */
+	u64 runs;
+	u64 lat_sum_us;
+	u32 lat_max_us;
+};
+
+/* hold a whole HE A-MPDU, whose subframes must go up in order */
+#define RTW89_PPDU_STS_RX_QUEUE_MAX IEEE80211_MAX_AMPDU_BUF_HE
+/* longest PPDU (aPPDUMaxTime 5.484 ms) plus latency of its status report */
+#define RTW89_PPDU_STS_TIMEOUT_US 8000
+
 struct rtw89_ppdu_sts_info {
 	struct sk_buff_head rx_queue[RTW89_PHY_MAX];
 	u8 curr_rx_ppdu_cnt[RTW89_PHY_MAX];
+	ktime_t queued_time[RTW89_PHY_MAX];
+	/* kicks NAPI to flush frames whose PPDU status never comes */
+	struct hrtimer flush_timer;
+	/* NAPI is scheduled by flush_timer instead of an interrupt */
+	bool napi_by_timer;
+
+	/* counted per PPDU, except immediate which counts frames */
+	u64 matched;
+	u64 unmatched;
+	u64 timeout;
+	u64 overflow;
+	u64 immediate;
 };
 
 struct rtw89_early_h2c {
@@ -4107,6 +4267,7 @@ struct rtw89_dev {
 	struct rtw89_hci_info hci;
 	struct rtw89_efuse efuse;
 	struct rtw89_traffic_stats stats;
+	struct rtw89_tfc_est tfc_est;
 
 	/* ensures exclusive access from mac80211 callbacks */
 	struct mutex mutex;
@@ -4114,8 +4275,10 @@ struct rtw89_dev {
 	/* used to protect rf read write */
 	struct mutex rf_mutex;
 	struct workqueue_struct *txq_wq;
-	struct work_struct txq_work;
-	struct delayed_work txq_reinvoke_work;
+	struct rtw89_txq_sched txq_sched[IEEE80211_NUM_ACS];
+	/* subscribes to tfc_est to allow aggregation wait under heavy TX */
+	struct notifier_block txq_tfc_est_nb;
+	bool txq_agg_wait_allowed;
 	/* used to protect ba_list and forbid_ba_list */
 	spinlock_t ba_lock;
 	/* txqs to setup ba session */
@@ -4140,6 +4303,8 @@ struct rtw89_dev {
 
 	DECLARE_BITMAP(hw_port, RTW89_PORT_NUM);
 	DECLARE_BITMAP(mac_id_map, RTW89_MAX_MAC_ID_NUM);
+	struct rtw89_sta __rcu *sta_on_mac_id[RTW89_MAX_MAC_ID_NUM];
+	struct rtw89_vif __rcu *vif_on_port[RTW89_PORT_NUM];
 	DECLARE_BITMAP(flags, NUM_OF_RTW89_FLAGS);
 	DECLARE_BITMAP(pkt_offload, RTW89_MAX_PKT_OFLD_NUM);
 
@@ -4168,6 +4333,8 @@ struct rtw89_dev {
 	struct rtw89_antdiv_info antdiv;
 
 	struct delayed_work track_work;
+	struct delayed_work dm_work;
+	struct rtw89_dm_task dm_tasks[RTW89_DM_TASK_NUM];
 	struct delayed_work coex_act1_work;
 	struct delayed_work coex_bt_devinfo_work;
 	struct delayed_work coex_rfk_chk_work;
@@ -4191,7 +4358,15 @@ struct rtw89_dev {
 	/* napi structure */
 	struct net_device netdev;
 	struct napi_struct napi;
+	struct napi_struct napi_tx;
+	/* budget of RX NAPI, TX release is not counted */
 	int napi_budget_countdown;
+	/* frames received in a poll are passed to mac80211 at once */
+	struct list_head rx_batch_list;
+	bool rx_batching;
+
+	/* bumped to rebuild TX descriptor templates of all stations */
+	atomic_t tx_desc_tmpl_gen;
 
 	/* HCI related data, keep last */
 	u8 priv[] __aligned(sizeof(void *));
@@ -4238,6 +4413,12 @@ static inline void rtw89_hci_recalc_int_mit(struct rtw89_dev *rtwdev)
 	rtwdev->hci.ops->recalc_int_mit(rtwdev);
 }
 
+static inline void rtw89_hci_recalc_link_pm(struct rtw89_dev *rtwdev)
+{
+	if (rtwdev->hci.ops->recalc_link_pm)
+		rtwdev->hci.ops->recalc_link_pm(rtwdev);
+}
+
 static inline u32 rtw89_hci_check_and_reclaim_tx_resource(struct rtw89_dev *rtwdev, u8 txch)
 {
 	return rtwdev->hci.ops->check_and_reclaim_tx_resource(rtwdev, txch);
@@ -4330,6 +4511,15 @@ static inline void rtw89_hci_clear(struct rtw89_dev *rtwdev, struct pci_dev *pde
 		rtwdev->hci.ops->clear(rtwdev, pdev);
 }
 
+static inline int rtw89_hci_resize_rings(struct rtw89_dev *rtwdev, u32 txbd_num,
+					 u32 rxbd_num, u32 txwd_num)
+{
+	if (!rtwdev->hci.ops->resize_rings)
+		return -EOPNOTSUPP;
+
+	return rtwdev->hci.ops->resize_rings(rtwdev, txbd_num, rxbd_num, txwd_num);
+}
+
 static inline
 struct rtw89_tx_skb_data *RTW89_TX_SKB_CB(struct sk_buff *skb)
 {
@@ -4542,6 +4732,7 @@ static inline void rtw89_core_txq_init(struct rtw89_dev *rtwdev,
 
 	rtwtxq = (struct rtw89_txq *)txq->drv_priv;
 	INIT_LIST_HEAD(&rtwtxq->list);
+	rtwtxq->wait_start = 0;
 }
 
 static inline struct ieee80211_vif *rtwvif_to_vif(struct rtw89_vif *rtwvif)
@@ -4578,6 +4769,30 @@ static inline struct rtw89_sta *sta_to_rtwsta_safe(struct ieee80211_sta *sta)
 	return sta ? (struct rtw89_sta *)sta->drv_priv : NULL;
 }
 
+static inline u32 rtw89_tx_airtime_est(struct sk_buff *skb)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 10, 0)
+	return ieee80211_info_get_tx_time_est(IEEE80211_SKB_CB(skb));
+#else
+	return 0;
+#endif
+}
+
+/* caller must hold rcu_read_lock(); RX runs in softirq which implies it */
+static inline
+struct rtw89_sta *rtw89_sta_rcu_dereference(struct rtw89_dev *rtwdev, u8 mac_id)
+{
+	if (unlikely(mac_id >= RTW89_MAX_MAC_ID_NUM))
+		return NULL;
+
+	return rcu_dereference(rtwdev->sta_on_mac_id[mac_id]);
+}
+
+static inline void rtw89_core_tx_desc_tmpl_invalidate(struct rtw89_dev *rtwdev)
+{
+	atomic_inc(&rtwdev->tx_desc_tmpl_gen);
+}
+
 static inline u8 rtw89_hw_to_rate_info_bw(enum rtw89_bandwidth hw_bw)
 {
 	if (hw_bw == RTW89_CHANNEL_WIDTH_160)
@@ -4885,6 +5100,25 @@ static inline void rtw89_ctrl_btg(struct rtw89_dev *rtwdev, bool btg)
 		chip->ops->ctrl_btg(rtwdev, btg);
 }
 
+void rtw89_core_fill_txdesc(struct rtw89_dev *rtwdev,
+			    struct rtw89_tx_desc_info *desc_info,
+			    void *txdesc);
+void rtw89_core_fill_txdesc_v1(struct rtw89_dev *rtwdev,
+			       struct rtw89_tx_desc_info *desc_info,
+			       void *txdesc);
+void rtw89_core_fill_txdesc_fwcmd_v1(struct rtw89_dev *rtwdev,
+				     struct rtw89_tx_desc_info *desc_info,
+				     void *txdesc);
+void rtw89_core_query_rxdesc(struct rtw89_dev *rtwdev,
+			     struct rtw89_rx_desc_info *desc_info,
+			     u8 *data, u32 data_offset);
+void rtw89_core_query_rxdesc_v1(struct rtw89_dev *rtwdev,
+				struct rtw89_rx_desc_info *desc_info,
+				u8 *data, u32 data_offset);
+
+/* Ops called per frame are compared with the known implementations, so they
+ * are direct calls instead of retpolines.
+ */
 static inline
 void rtw89_chip_query_rxdesc(struct rtw89_dev *rtwdev,
 			     struct rtw89_rx_desc_info *desc_info,
@@ -4892,7 +5126,9 @@ void rtw89_chip_query_rxdesc(struct rtw89_dev *rtwdev,
 {
 	const struct rtw89_chip_info *chip = rtwdev->chip;
 
-	chip->ops->query_rxdesc(rtwdev, desc_info, data, data_offset);
+	INDIRECT_CALL_2(chip->ops->query_rxdesc,
+			rtw89_core_query_rxdesc, rtw89_core_query_rxdesc_v1,
+			rtwdev, desc_info, data, data_offset);
 }
 
 static inline
@@ -4902,7 +5138,9 @@ void rtw89_chip_fill_txdesc(struct rtw89_dev *rtwdev,
 {
 	const struct rtw89_chip_info *chip = rtwdev->chip;
 
-	chip->ops->fill_txdesc(rtwdev, desc_info, txdesc);
+	INDIRECT_CALL_2(chip->ops->fill_txdesc,
+			rtw89_core_fill_txdesc, rtw89_core_fill_txdesc_v1,
+			rtwdev, desc_info, txdesc);
 }
 
 static inline
@@ -4912,7 +5150,9 @@ void rtw89_chip_fill_txdesc_fwcmd(struct rtw89_dev *rtwdev,
 {
 	const struct rtw89_chip_info *chip = rtwdev->chip;
 
-	chip->ops->fill_txdesc_fwcmd(rtwdev, desc_info, txdesc);
+	INDIRECT_CALL_2(chip->ops->fill_txdesc_fwcmd,
+			rtw89_core_fill_txdesc, rtw89_core_fill_txdesc_fwcmd_v1,
+			rtwdev, desc_info, txdesc);
 }
 
 static inline
@@ -5045,25 +5285,16 @@ int rtw89_h2c_tx(struct rtw89_dev *rtwdev,
 void rtw89_core_tx_kick_off(struct rtw89_dev *rtwdev, u8 qsel);
 int rtw89_core_tx_kick_off_and_wait(struct rtw89_dev *rtwdev, struct sk_buff *skb,
 				    int qsel, unsigned int timeout);
-void rtw89_core_fill_txdesc(struct rtw89_dev *rtwdev,
-			    struct rtw89_tx_desc_info *desc_info,
-			    void *txdesc);
-void rtw89_core_fill_txdesc_v1(struct rtw89_dev *rtwdev,
-			       struct rtw89_tx_desc_info *desc_info,
-			       void *txdesc);
-void rtw89_core_fill_txdesc_fwcmd_v1(struct rtw89_dev *rtwdev,
-				     struct rtw89_tx_desc_info *desc_info,
-				     void *txdesc);
 void rtw89_core_rx(struct rtw89_dev *rtwdev,
 		   struct rtw89_rx_desc_info *desc_info,
 		   struct sk_buff *skb);
-void rtw89_core_query_rxdesc(struct rtw89_dev *rtwdev,
-			     struct rtw89_rx_desc_info *desc_info,
-			     u8 *data, u32 data_offset);
+void rtw89_core_rx_batch_begin(struct rtw89_dev *rtwdev);
+void rtw89_core_rx_batch_end(struct rtw89_dev *rtwdev);
 void rtw89_core_napi_start(struct rtw89_dev *rtwdev);
 void rtw89_core_napi_stop(struct rtw89_dev *rtwdev);
 void rtw89_core_napi_init(struct rtw89_dev *rtwdev);
 void rtw89_core_napi_deinit(struct rtw89_dev *rtwdev);
+void rtw89_core_napi_schedule(struct rtw89_dev *rtwdev);
 int rtw89_core_sta_add(struct rtw89_dev *rtwdev,
 		       struct ieee80211_vif *vif,
 		       struct ieee80211_sta *sta);
@@ -5109,8 +5340,21 @@ int rtw89_regd_setup(struct rtw89_dev *rtwdev);
 int rtw89_regd_init(struct rtw89_dev *rtwdev,
 		    void (*reg_notifier)(struct wiphy *wiphy, struct regulatory_request *request));
 void rtw89_regd_notifier(struct wiphy *wiphy, struct regulatory_request *request);
-void rtw89_traffic_stats_init(struct rtw89_dev *rtwdev,
-			      struct rtw89_traffic_stats *stats);
+const char *rtw89_dm_task_name(enum rtw89_dm_task_id id);
+int rtw89_tfc_est_register_notifier(struct rtw89_dev *rtwdev,
+				    struct notifier_block *nb);
+int rtw89_tfc_est_unregister_notifier(struct rtw89_dev *rtwdev,
+				      struct notifier_block *nb);
+void rtw89_core_txq_sched_queue(struct rtw89_dev *rtwdev, u8 ac);
+void rtw89_core_txq_sched_queue_all(struct rtw89_dev *rtwdev);
+void rtw89_core_txq_sched_flush(struct rtw89_dev *rtwdev);
+void rtw89_core_sta_airtime_release(struct rtw89_dev *rtwdev,
+				    struct rtw89_sta *rtwsta,
+				    struct sk_buff *skb);
+int rtw89_traffic_stats_init(struct rtw89_dev *rtwdev,
+			     struct rtw89_traffic_stats *stats);
+void rtw89_traffic_stats_deinit(struct rtw89_dev *rtwdev,
+				struct rtw89_traffic_stats *stats);
 int rtw89_wait_for_cond(struct rtw89_wait_info *wait, unsigned int cond);
 void rtw89_complete_cond(struct rtw89_wait_info *wait, unsigned int cond,
 			 const struct rtw89_completion_data *data);
@@ -3512,6 +3512,448 @@ static int rtw89_debug_priv_stations_get(struct seq_file *m, void *v)
 	return 0;
 }
 
+static int rtw89_debug_priv_ppdu_sts_get(struct seq_file *m, void *v)
+{
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_ppdu_sts_info *ppdu_sts = &rtwdev->ppdu_sts;
+	u8 band;
+
+	seq_printf(m, "queue max: %d, timeout: %d us\n",
+		   RTW89_PPDU_STS_RX_QUEUE_MAX, RTW89_PPDU_STS_TIMEOUT_US);
+	for (band = 0; band < RTW89_PHY_MAX; band++)
+		seq_printf(m, "band%d queued: %u\n", band,
+			   skb_queue_len(&ppdu_sts->rx_queue[band]));
+	seq_printf(m, "PPDU matched: %llu\n", ppdu_sts->matched);
+	seq_printf(m, "PPDU unmatched: %llu\n", ppdu_sts->unmatched);
+	seq_printf(m, "PPDU timed out: %llu\n", ppdu_sts->timeout);
+	seq_printf(m, "queue overflows: %llu\n", ppdu_sts->overflow);
+	seq_printf(m, "frames delivered immediately: %llu\n", ppdu_sts->immediate);
+
+	return 0;
+}
+
+static void rtw89_agg_wait_get_iter(void *data, struct ieee80211_sta *sta)
+{
+	struct seq_file *m = (struct seq_file *)data;
+	struct rtw89_txq *rtwtxq;
+	u8 tid;
+
+	for (tid = 0; tid < IEEE80211_NUM_TIDS; tid++) {
+		if (!sta->txq[tid])
+			continue;
+
+		rtwtxq = (struct rtw89_txq *)sta->txq[tid]->drv_priv;
+		if (!rtwtxq->wait_cnt)
+			continue;
+
+		seq_printf(m, "%pM tid%u: waits=%u expired=%u gained=%llu%s\n",
+			   sta->addr, tid, rtwtxq->wait_cnt, rtwtxq->wait_expired,
+			   rtwtxq->wait_gained, rtwtxq->wait_start ? " (waiting)" : "");
+	}
+}
+
+static int rtw89_debug_priv_agg_wait_get(struct seq_file *m, void *v)
+{
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	static const char * const ac_name[IEEE80211_NUM_ACS] = {
+		[IEEE80211_AC_VO] = "VO",
+		[IEEE80211_AC_VI] = "VI",
+		[IEEE80211_AC_BE] = "BE",
+		[IEEE80211_AC_BK] = "BK",
+	};
+	u8 ac;
+
+	for (ac = 0; ac < IEEE80211_NUM_ACS; ac++)
+		seq_printf(m, "ac%u (%s) window: %u us\n", ac, ac_name[ac],
+			   READ_ONCE(rtwdev->txq_sched[ac].agg_wait_us));
+
+	ieee80211_iterate_stations_atomic(rtwdev->hw, rtw89_agg_wait_get_iter, m);
+
+	return 0;
+}
+
+static ssize_t rtw89_debug_priv_agg_wait_set(struct file *filp,
+					     const char __user *user_buf,
+					     size_t count, loff_t *loff)
+{
+	struct seq_file *m = (struct seq_file *)filp->private_data;
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	char buf[32];
+	size_t buf_size;
+	u32 ac, us;
+	int num;
+
+	buf_size = min(count, sizeof(buf) - 1);
+	if (copy_from_user(buf, user_buf, buf_size))
+		return -EFAULT;
+
+	buf[buf_size] = '\0';
+	num = sscanf(buf, "%u %u", &ac, &us);
+	if (num != 2 || ac >= IEEE80211_NUM_ACS || us > USEC_PER_SEC) {
+		rtw89_info(rtwdev, "invalid format: <ac> <us>\n");
+		return -EINVAL;
+	}
+
+	WRITE_ONCE(rtwdev->txq_sched[ac].agg_wait_us, us);
+
+	return count;
+}
+
+static int rtw89_debug_priv_txq_sched_get(struct seq_file *m, void *v)
+{
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_txq_sched *sched;
+	u8 ac;
+
+	seq_puts(m, "scheduling latency from queueing to run of TX work:\n");
+	for (ac = 0; ac < IEEE80211_NUM_ACS; ac++) {
+		sched = &rtwdev->txq_sched[ac];
+		seq_printf(m, "ac%u: runs=%llu avg=%llu us max=%u us\n", ac,
+			   sched->runs,
+			   sched->runs ? div64_u64(sched->lat_sum_us, sched->runs) : 0,
+			   sched->lat_max_us);
+	}
+
+	return 0;
+}
+
+static int rtw89_debug_priv_tfc_est_get(struct seq_file *m, void *v)
+{
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_tfc_est_info *info = &rtwdev->tfc_est.info;
+	struct rtw89_traffic_stats *stats = &rtwdev->stats;
+
+	seq_printf(m, "period: %d ms (%s)\n", RTW89_TFC_EST_PERIOD_MS,
+		   test_bit(RTW89_FLAG_TFC_EST_RUNNING, rtwdev->flags) ?
+		   "running" : "stopped");
+	seq_printf(m, "TX: %u Mbps lv %d (track %u Mbps lv %d)\n",
+		   READ_ONCE(info->tx_throughput), READ_ONCE(info->tx_tfc_lv),
+		   stats->tx_throughput, stats->tx_tfc_lv);
+	seq_printf(m, "RX: %u Mbps lv %d (track %u Mbps lv %d)\n",
+		   READ_ONCE(info->rx_throughput), READ_ONCE(info->rx_tfc_lv),
+		   stats->rx_throughput, stats->rx_tfc_lv);
+
+	return 0;
+}
+
+static int rtw89_debug_priv_dm_task_get(struct seq_file *m, void *v)
+{
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_dm_task *task;
+	enum rtw89_dm_task_id id;
+
+	seq_printf(m, "%-12s %6s %10s %8s %8s %8s\n", "task", "period",
+		   "runs", "avg(us)", "max(us)", "skipped");
+
+	mutex_lock(&rtwdev->mutex);
+	for (id = 0; id < RTW89_DM_TASK_NUM; id++) {
+		task = &rtwdev->dm_tasks[id];
+		seq_printf(m, "%-12s %6u %10llu %8llu %8u %8u\n",
+			   rtw89_dm_task_name(id), task->period_ms, task->runs,
+			   task->runs ? div64_u64(task->run_sum_us, task->runs) : 0,
+			   task->run_max_us, task->skipped);
+	}
+	mutex_unlock(&rtwdev->mutex);
+
+	return 0;
+}
+
+static ssize_t rtw89_debug_priv_dm_task_set(struct file *filp,
+					    const char __user *user_buf,
+					    size_t count, loff_t *loff)
+{
+	struct seq_file *m = (struct seq_file *)filp->private_data;
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	enum rtw89_dm_task_id id;
+	char name[16];
+	char buf[32];
+	size_t buf_size;
+	u32 period;
+	int num;
+
+	buf_size = min(count, sizeof(buf) - 1);
+	if (copy_from_user(buf, user_buf, buf_size))
+		return -EFAULT;
+
+	buf[buf_size] = '\0';
+	num = sscanf(buf, "%15s %u", name, &period);
+	if (num != 2 || period < RTW89_DM_TASK_PERIOD_MIN_MS ||
+	    period > RTW89_DM_TASK_PERIOD_MAX_MS) {
+		rtw89_info(rtwdev, "invalid format: <task> <period_ms (%d-%d)>\n",
+			   RTW89_DM_TASK_PERIOD_MIN_MS, RTW89_DM_TASK_PERIOD_MAX_MS);
+		return -EINVAL;
+	}
+
+	for (id = 0; id < RTW89_DM_TASK_NUM; id++)
+		if (!strcmp(name, rtw89_dm_task_name(id)))
+			break;
+
+	if (id == RTW89_DM_TASK_NUM) {
+		rtw89_info(rtwdev, "unknown task: %s\n", name);
+		return -EINVAL;
+	}
+
+	/* takes effect from next run of track_work */
+	WRITE_ONCE(rtwdev->dm_tasks[id].period_ms, period);
+
+	return count;
+}
+
+#define RTW89_DESC_BENCH_LOOPS 100000
+
+static u64 rtw89_desc_bench_tx(struct rtw89_dev *rtwdev,
+			       struct rtw89_tx_desc_info *desc_info,
+			       void *txdesc, bool indirect)
+{
+	void (*fill)(struct rtw89_dev *rtwdev,
+		     struct rtw89_tx_desc_info *desc_info, void *txdesc);
+	u64 start;
+	int i;
+
+	fill = rtwdev->chip->ops->fill_txdesc;
+	start = ktime_get_ns();
+	for (i = 0; i < RTW89_DESC_BENCH_LOOPS; i++) {
+		if (indirect) {
+			OPTIMIZER_HIDE_VAR(fill);
+			fill(rtwdev, desc_info, txdesc);
+		} else {
+			rtw89_chip_fill_txdesc(rtwdev, desc_info, txdesc);
+		}
+	}
+
+	return ktime_get_ns() - start;
+}
+
+static u64 rtw89_desc_bench_rx(struct rtw89_dev *rtwdev,
+			       struct rtw89_rx_desc_info *desc_info,
+			       u8 *rxdesc, bool indirect)
+{
+	void (*query)(struct rtw89_dev *rtwdev,
+		      struct rtw89_rx_desc_info *desc_info,
+		      u8 *data, u32 data_offset);
+	u64 start;
+	int i;
+
+	query = rtwdev->chip->ops->query_rxdesc;
+	start = ktime_get_ns();
+	for (i = 0; i < RTW89_DESC_BENCH_LOOPS; i++) {
+		if (indirect) {
+			OPTIMIZER_HIDE_VAR(query);
+			query(rtwdev, desc_info, rxdesc, 0);
+		} else {
+			rtw89_chip_query_rxdesc(rtwdev, desc_info, rxdesc, 0);
+		}
+	}
+
+	return ktime_get_ns() - start;
+}
+
+static int rtw89_debug_priv_desc_bench_get(struct seq_file *m, void *v)
+{
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_tx_desc_info tx_info = {
+		.pkt_size = 1500,
+		.qsel = RTW89_TX_QSEL_BE_0,
+		.ch_dma = RTW89_TXCH_ACH0,
+		.wd_page = true,
+		.en_wd_info = true,
+		.use_rate = true,
+		.data_rate = RTW89_HW_RATE_MCS7,
+	};
+	struct rtw89_rx_desc_info rx_info = {};
+	struct rtw89_rxdesc_long rxd = {};
+	u8 txdesc[sizeof(struct rtw89_txwd_body_v1) +
+		  sizeof(struct rtw89_txwd_info)] __aligned(4);
+	u64 tx_ind, tx_dir, rx_ind, rx_dir;
+
+	rxd.dword0 = le32_encode_bits(1500, AX_RXD_RPKT_LEN_MASK) |
+		     le32_encode_bits(1, AX_RXD_LONG_RXD);
+
+	local_bh_disable();
+	tx_ind = rtw89_desc_bench_tx(rtwdev, &tx_info, txdesc, true);
+	tx_dir = rtw89_desc_bench_tx(rtwdev, &tx_info, txdesc, false);
+	rx_ind = rtw89_desc_bench_rx(rtwdev, &rx_info, (u8 *)&rxd, true);
+	rx_dir = rtw89_desc_bench_rx(rtwdev, &rx_info, (u8 *)&rxd, false);
+	local_bh_enable();
+
+	seq_printf(m, "loops: %d\n", RTW89_DESC_BENCH_LOOPS);
+	seq_printf(m, "%-14s %12s %12s\n", "", "indirect(ns)", "direct(ns)");
+	seq_printf(m, "%-14s %12llu %12llu\n", "fill_txdesc", tx_ind, tx_dir);
+	seq_printf(m, "%-14s %12llu %12llu\n", "query_rxdesc", rx_ind, rx_dir);
+
+	return 0;
+}
+
+static int rtw89_debug_priv_pci_stats_get(struct seq_file *m, void *v)
+{
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	struct rtw89_pci_rx_ring *rx_ring = &rtwpci->rx_rings[RTW89_RXCH_RXQ];
+	struct rtw89_pci_link_pm *link_pm = &rtwpci->link_pm;
+	const struct rtw89_pci_info *info = rtwdev->pci_info;
+	struct rtw89_pci_dim *dim = &rtwpci->dim;
+	struct rtw89_pci_tx_ring *tx_ring;
+	int i;
+
+	seq_puts(m, "RXQ:\n");
+	seq_printf(m, "\tbuffer: %s\n", rx_ring->page_pool ? "page pool" : "skb");
+	seq_printf(m, "\tzero copy: %llu\n", rx_ring->rx_zero_copy);
+	seq_printf(m, "\tcopied: %llu\n", rx_ring->rx_copied);
+	seq_printf(m, "\tbytes: %llu\n", rx_ring->rx_bytes);
+
+	seq_puts(m, "DIM:\n");
+	seq_printf(m, "\tprofile: %u (INT_MIT_RX=0x%08x)\n",
+		   dim->hw_profile_ix, dim->hw_val);
+	seq_printf(m, "\tnet_dim profile: %u, tune state: %u, tired: %u\n",
+		   dim->dim.profile_ix, dim->dim.tune_state, dim->dim.tired);
+	seq_printf(m, "\tlast stats: %d packets/ms, %d bytes/ms, %d events/ms\n",
+		   dim->dim.prev_stats.ppms, dim->dim.prev_stats.bpms,
+		   dim->dim.prev_stats.epms);
+	seq_printf(m, "\ttransitions: %u\n", dim->transitions);
+	seq_puts(m, "\tpolls per profile:");
+	for (i = 0; i < RTW89_PCI_DIM_PROFILE_NUM; i++)
+		seq_printf(m, " %u", dim->profile_polls[i]);
+	seq_puts(m, "\n");
+
+	seq_printf(m, "TX mapped/copied/sg/linearized (copybreak %u):\n",
+		   rtwpci->tx_rings[RTW89_TXCH_ACH0].wd_ring.copybreak);
+	for (i = 0; i < RTW89_TXCH_NUM; i++) {
+		if (info->tx_dma_ch_mask & BIT(i) || i == RTW89_TXCH_CH12)
+			continue;
+
+		tx_ring = &rtwpci->tx_rings[i];
+		seq_printf(m, "\tTXCH%d: %llu/%llu/%llu/%llu\n", i,
+			   tx_ring->tx_mapped, tx_ring->tx_copied,
+			   tx_ring->tx_sg, tx_ring->tx_linearized);
+	}
+
+	seq_printf(m, "TX status batches/reported: %llu/%llu\n",
+		   rtwpci->tx_status_batches, rtwpci->tx_status_reported);
+
+	seq_printf(m, "Link PM: %s (ASPM L1 %d, L1SS %d, LTR %d)\n",
+		   link_pm->state == RTW89_PCI_LINK_PM_PERF ? "perf" : "saving",
+		   link_pm->aspm_l1, link_pm->l1ss, link_pm->ltr);
+	seq_printf(m, "\thold: %u, low latency flow: %d\n",
+		   link_pm->hold, link_pm->lat_flow);
+	seq_printf(m, "\ttransitions to perf/saving: %u/%u\n",
+		   link_pm->to_perf, link_pm->to_saving);
+	if (link_pm->to_perf)
+		seq_printf(m, "\tlast transition: %u ms ago\n",
+			   jiffies_to_msecs(jiffies - link_pm->last_change));
+
+	seq_printf(m, "IRQ hardirq/thread: %llu/%llu\n",
+		   rtwpci->irq_lat.irqs[RTW89_PCI_IRQ_PATH_HARDIRQ],
+		   rtwpci->irq_lat.irqs[RTW89_PCI_IRQ_PATH_THREAD]);
+	seq_puts(m, "IRQ to NAPI poll latency (us): RX hardirq/thread, TX hardirq/thread\n");
+	for (i = 0; i < RTW89_PCI_IRQ_LAT_HIST_NUM; i++) {
+		if (i == RTW89_PCI_IRQ_LAT_HIST_NUM - 1)
+			seq_printf(m, "	>= %u", 1 << (i - 1));
+		else
+			seq_printf(m, "	< %u", 1 << i);
+		seq_printf(m, ": %u/%u, %u/%u\n",
+			   rtwpci->irq_lat.rx.hist[RTW89_PCI_IRQ_PATH_HARDIRQ][i],
+			   rtwpci->irq_lat.rx.hist[RTW89_PCI_IRQ_PATH_THREAD][i],
+			   rtwpci->irq_lat.tx.hist[RTW89_PCI_IRQ_PATH_HARDIRQ][i],
+			   rtwpci->irq_lat.tx.hist[RTW89_PCI_IRQ_PATH_THREAD][i]);
+	}
+
+	seq_puts(m, "Lock acquired/contended:\n");
+	seq_printf(m, "\tRPQ: %llu/%llu\n", rtwpci->rpq_lock_stats.acquired,
+		   rtwpci->rpq_lock_stats.contended);
+	for (i = 0; i < RTW89_TXCH_NUM; i++) {
+		if (info->tx_dma_ch_mask & BIT(i))
+			continue;
+
+		tx_ring = &rtwpci->tx_rings[i];
+		seq_printf(m, "\tTXCH%d: %llu/%llu\n", i,
+			   tx_ring->lock_stats.acquired,
+			   tx_ring->lock_stats.contended);
+	}
+
+	return 0;
+}
+
+static int rtw89_debug_priv_pci_ring_get(struct seq_file *m, void *v)
+{
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	const struct rtw89_pci_info *info = rtwdev->pci_info;
+	struct rtw89_pci_tx_ring *tx_ring;
+	int i;
+
+	seq_printf(m, "txbd_num: %u, rxbd_num: %u, txwd_num: %u\n",
+		   rtwpci->txbd_num, rtwpci->rxbd_num, rtwpci->txwd_num);
+	if (!rtwpci->rings_allocated) {
+		seq_puts(m, "rings are not allocated, resize them to retry\n");
+		return 0;
+	}
+	seq_printf(m, "BD arena: %u bytes, WD arena: %u bytes (0: separate rings)\n",
+		   rtwpci->bd_arena.size, rtwpci->wd_arena.size);
+
+	seq_puts(m, "TX high-watermark BD/WD:\n");
+	for (i = 0; i < RTW89_TXCH_NUM; i++) {
+		if (info->tx_dma_ch_mask & BIT(i))
+			continue;
+
+		tx_ring = &rtwpci->tx_rings[i];
+		seq_printf(m, "\tTXCH%d: %u/%u\n", i, tx_ring->bd_hwm,
+			   tx_ring->wd_hwm);
+	}
+
+	seq_puts(m, "RX high-watermark BD:\n");
+	seq_printf(m, "\tRXQ: %u\n", rtwpci->rx_rings[RTW89_RXCH_RXQ].bd_hwm);
+	seq_printf(m, "\tRPQ: %u\n", rtwpci->rx_rings[RTW89_RXCH_RPQ].bd_hwm);
+
+	return 0;
+}
+
+static ssize_t rtw89_debug_priv_pci_ring_set(struct file *filp,
+					     const char __user *user_buf,
+					     size_t count, loff_t *loff)
+{
+	struct seq_file *m = (struct seq_file *)filp->private_data;
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	u32 txbd_num, rxbd_num, txwd_num;
+	char buf[32];
+	size_t buf_size;
+	int num;
+	int ret;
+
+	buf_size = min(count, sizeof(buf) - 1);
+	if (copy_from_user(buf, user_buf, buf_size))
+		return -EFAULT;
+
+	buf[buf_size] = '\0';
+	num = sscanf(buf, "%u %u %u", &txbd_num, &rxbd_num, &txwd_num);
+	if (num != 3) {
+		rtw89_info(rtwdev, "invalid format: <txbd_num> <rxbd_num> <txwd_num>\n");
+		return -EINVAL;
+	}
+
+	mutex_lock(&rtwdev->mutex);
+	ret = rtw89_hci_resize_rings(rtwdev, txbd_num, rxbd_num, txwd_num);
+	mutex_unlock(&rtwdev->mutex);
+
+	if (ret) {
+		rtw89_info(rtwdev, "failed to resize rings: %d (interface must be down)\n",
+			   ret);
+		return ret;
+	}
+
+	return count;
+}
+
 static struct rtw89_debugfs_priv rtw89_debug_priv_read_reg = {
 	.cb_read = rtw89_debug_priv_read_reg_get,
 	.cb_write = rtw89_debug_priv_read_reg_select,
@@ -3587,6 +4029,41 @@ static struct rtw89_debugfs_priv rtw89_debug_priv_stations = {
 	.cb_read = rtw89_debug_priv_stations_get,
 };
 
+static struct rtw89_debugfs_priv rtw89_debug_priv_ppdu_sts = {
+	.cb_read = rtw89_debug_priv_ppdu_sts_get,
+};
+
+static struct rtw89_debugfs_priv rtw89_debug_priv_agg_wait = {
+	.cb_read = rtw89_debug_priv_agg_wait_get,
+	.cb_write = rtw89_debug_priv_agg_wait_set,
+};
+
+static struct rtw89_debugfs_priv rtw89_debug_priv_txq_sched = {
+	.cb_read = rtw89_debug_priv_txq_sched_get,
+};
+
+static struct rtw89_debugfs_priv rtw89_debug_priv_tfc_est = {
+	.cb_read = rtw89_debug_priv_tfc_est_get,
+};
+
+static struct rtw89_debugfs_priv rtw89_debug_priv_dm_task = {
+	.cb_read = rtw89_debug_priv_dm_task_get,
+	.cb_write = rtw89_debug_priv_dm_task_set,
+};
+
+static struct rtw89_debugfs_priv rtw89_debug_priv_desc_bench = {
+	.cb_read = rtw89_debug_priv_desc_bench_get,
+};
+
+static struct rtw89_debugfs_priv rtw89_debug_priv_pci_stats = {
+	.cb_read = rtw89_debug_priv_pci_stats_get,
+};
+
+static struct rtw89_debugfs_priv rtw89_debug_priv_pci_ring = {
+	.cb_read = rtw89_debug_priv_pci_ring_get,
+	.cb_write = rtw89_debug_priv_pci_ring_set,
+};
+
 #define rtw89_debugfs_add(name, mode, fopname, parent)				\
 	do {									\
 		rtw89_debug_priv_ ##name.rtwdev = rtwdev;			\
@@ -3627,6 +4104,16 @@ void rtw89_debugfs_init(struct rtw89_dev *rtwdev)
 	rtw89_debugfs_add_w(fw_log_manual);
 	rtw89_debugfs_add_r(phy_info);
 	rtw89_debugfs_add_r(stations);
+	rtw89_debugfs_add_r(ppdu_sts);
+	rtw89_debugfs_add_rw(agg_wait);
+	rtw89_debugfs_add_r(txq_sched);
+	rtw89_debugfs_add_r(tfc_est);
+	rtw89_debugfs_add_rw(dm_task);
+	rtw89_debugfs_add_r(desc_bench);
+	if (rtwdev->hci.type == RTW89_HCI_TYPE_PCIE) {
+		rtw89_debugfs_add_r(pci_stats);
+		rtw89_debugfs_add_rw(pci_ring);
+	}
 }
 #endif
 
@@ -51,7 +51,7 @@ static void rtw89_ops_wake_tx_queue(struct ieee80211_hw *hw,
 	struct rtw89_dev *rtwdev = hw->priv;
 
 	ieee80211_schedule_txq(hw, txq);
-	queue_work(rtwdev->txq_wq, &rtwdev->txq_work);
+	rtw89_core_txq_sched_queue(rtwdev, txq->ac);
 }
 
 static int rtw89_ops_start(struct ieee80211_hw *hw)
@@ -131,13 +131,19 @@ static int rtw89_ops_add_interface(struct ieee80211_hw *hw,
 	INIT_DELAYED_WORK(&rtwvif->roc.roc_work, rtw89_roc_work);
 	rtw89_leave_ps_mode(rtwdev);
 
-	rtw89_traffic_stats_init(rtwdev, &rtwvif->stats);
+	ret = rtw89_traffic_stats_init(rtwdev, &rtwvif->stats);
+	if (ret) {
+		list_del_init(&rtwvif->list);
+		goto out;
+	}
+
 	rtw89_vif_type_mapping(vif, false);
 	rtwvif->port = rtw89_core_acquire_bit_map(rtwdev->hw_port,
 						  RTW89_PORT_NUM);
 	if (rtwvif->port == RTW89_PORT_NUM) {
 		ret = -ENOSPC;
 		list_del_init(&rtwvif->list);
+		rtw89_traffic_stats_deinit(rtwdev, &rtwvif->stats);
 		goto out;
 	}
 
@@ -154,11 +160,15 @@ static int rtw89_ops_add_interface(struct ieee80211_hw *hw,
 	if (ret) {
 		rtw89_core_release_bit_map(rtwdev->hw_port, rtwvif->port);
 		list_del_init(&rtwvif->list);
+		rtw89_core_txq_sched_flush(rtwdev);
+		rtw89_traffic_stats_deinit(rtwdev, &rtwvif->stats);
 		goto out;
 	}
 
 	rtw89_core_txq_init(rtwdev, vif->txq);
 
+	rcu_assign_pointer(rtwdev->vif_on_port[rtwvif->port], rtwvif);
+
 	rtw89_btc_ntfy_role_info(rtwdev, rtwvif, NULL, BTC_ROLE_START);
 
 	rtw89_recalc_lps(rtwdev);
@@ -183,9 +193,16 @@ static void rtw89_ops_remove_interface(struct ieee80211_hw *hw,
 	mutex_lock(&rtwdev->mutex);
 	rtw89_leave_ps_mode(rtwdev);
 	rtw89_btc_ntfy_role_info(rtwdev, rtwvif, NULL, BTC_ROLE_STOP);
+	if (rcu_access_pointer(rtwdev->vif_on_port[rtwvif->port]) == rtwvif) {
+		RCU_INIT_POINTER(rtwdev->vif_on_port[rtwvif->port], NULL);
+		synchronize_rcu();
+	}
 	rtw89_mac_remove_vif(rtwdev, rtwvif);
 	rtw89_core_release_bit_map(rtwdev->hw_port, rtwvif->port);
 	list_del_init(&rtwvif->list);
+	/* TX works may still be writing a dequeued frame of this vif */
+	rtw89_core_txq_sched_flush(rtwdev);
+	rtw89_traffic_stats_deinit(rtwdev, &rtwvif->stats);
 	rtw89_recalc_lps(rtwdev);
 	rtw89_enter_ips_by_hwflags(rtwdev);
 
@@ -432,6 +449,7 @@ static void rtw89_ops_bss_info_changed(struct ieee80211_hw *hw,
 
 	if (changed & BSS_CHANGED_BSSID) {
 		ether_addr_copy(rtwvif->bssid, conf->bssid);
+		rtwvif->bcn_rssi_ofld_time = jiffies - RTW89_BCN_RSSI_OFLD_INTVL;
 		rtw89_cam_bssid_changed(rtwdev, rtwvif);
 		rtw89_fw_h2c_cam(rtwdev, rtwvif, NULL, NULL);
 	}
@@ -593,6 +611,7 @@ static int rtw89_ops_sta_state(struct ieee80211_hw *hw,
 	mutex_lock(&rtwdev->mutex);
 	rtw89_leave_ps_mode(rtwdev);
 	ret = __rtw89_ops_sta_state(hw, vif, sta, old_state, new_state);
+	rtw89_core_tx_desc_tmpl_invalidate(rtwdev);
 	mutex_unlock(&rtwdev->mutex);
 
 	return ret;
@@ -630,6 +649,7 @@ static int rtw89_ops_set_key(struct ieee80211_hw *hw, enum set_key_cmd cmd,
 		break;
 	}
 
+	rtw89_core_tx_desc_tmpl_invalidate(rtwdev);
 out:
 	mutex_unlock(&rtwdev->mutex);
 
@@ -660,6 +680,7 @@ static int rtw89_ops_ampdu_action(struct ieee80211_hw *hw,
 	case IEEE80211_AMPDU_TX_STOP_FLUSH_CONT:
 		mutex_lock(&rtwdev->mutex);
 		clear_bit(RTW89_TXQ_F_AMPDU, &rtwtxq->flags);
+		rtw89_core_tx_desc_tmpl_invalidate(rtwdev);
 		mutex_unlock(&rtwdev->mutex);
 		ieee80211_stop_tx_ba_cb_irqsafe(vif, sta->addr, tid);
 		break;
@@ -668,6 +689,7 @@ static int rtw89_ops_ampdu_action(struct ieee80211_hw *hw,
 		set_bit(RTW89_TXQ_F_AMPDU, &rtwtxq->flags);
 		rtwsta->ampdu_params[tid].agg_num = params->buf_size;
 		rtwsta->ampdu_params[tid].amsdu = params->amsdu;
+		rtw89_core_tx_desc_tmpl_invalidate(rtwdev);
 		rtw89_leave_ps_mode(rtwdev);
 		mutex_unlock(&rtwdev->mutex);
 		break;
@@ -785,6 +807,7 @@ static int rtw89_ops_set_bitrate_mask(struct ieee80211_hw *hw,
 	mutex_lock(&rtwdev->mutex);
 	rtw89_phy_rate_pattern_vif(rtwdev, vif, mask);
 	rtw89_ra_mask_info_update(rtwdev, vif, mask);
+	rtw89_core_tx_desc_tmpl_invalidate(rtwdev);
 	mutex_unlock(&rtwdev->mutex);
 
 	return 0;
@@ -904,6 +927,7 @@ static void rtw89_ops_sta_rc_update(struct ieee80211_hw *hw,
 	struct rtw89_dev *rtwdev = hw->priv;
 
 	rtw89_phy_ra_updata_sta(rtwdev, sta, changed);
+	rtw89_core_tx_desc_tmpl_invalidate(rtwdev);
 }
 
 static int rtw89_ops_add_chanctx(struct ieee80211_hw *hw,
@@ -1067,6 +1091,7 @@ static int rtw89_ops_suspend(struct ieee80211_hw *hw,
 
 	set_bit(RTW89_FLAG_FORBIDDEN_TRACK_WROK, rtwdev->flags);
 	cancel_delayed_work_sync(&rtwdev->track_work);
+	cancel_delayed_work_sync(&rtwdev->dm_work);
 
 	mutex_lock(&rtwdev->mutex);
 	ret = rtw89_wow_suspend(rtwdev, wowlan);
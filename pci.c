@@ -3,21 +3,65 @@
  */
 
 #include <linux/pci.h>
+#include <linux/version.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 6, 0)
+#include <net/page_pool/helpers.h>
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(5, 15, 0)
+#include <net/page_pool.h>
+#endif
 
 #include "mac.h"
 #include "pci.h"
 #include "reg.h"
 #include "ser.h"
 
+/* skb_mark_for_recycle() is needed to hand page_pool pages to the stack */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 15, 0)
+#define RTW89_PCI_RX_ZERO_COPY
+#endif
+
 static bool rtw89_pci_disable_clkreq;
 static bool rtw89_pci_disable_aspm_l1;
 static bool rtw89_pci_disable_l1ss;
+static bool rtw89_pci_disable_rx_zero_copy;
+static bool rtw89_pci_disable_dim;
+static bool rtw89_pci_threaded_napi;
+static bool rtw89_pci_disable_tx_sg;
+static unsigned int rtw89_pci_txbd_num = RTW89_PCI_TXBD_NUM_DEF;
+static unsigned int rtw89_pci_rxbd_num = RTW89_PCI_RXBD_NUM_DEF;
+static unsigned int rtw89_pci_txwd_num = RTW89_PCI_TXWD_NUM_DEF;
+static bool rtw89_pci_disable_dma_arena;
+static bool rtw89_pci_disable_irq_fast_path;
+static bool rtw89_pci_disable_link_pm;
+static unsigned int rtw89_pci_tx_copybreak = 128;
 module_param_named(disable_clkreq, rtw89_pci_disable_clkreq, bool, 0644);
 module_param_named(disable_aspm_l1, rtw89_pci_disable_aspm_l1, bool, 0644);
 module_param_named(disable_aspm_l1ss, rtw89_pci_disable_l1ss, bool, 0644);
+module_param_named(disable_rx_zero_copy, rtw89_pci_disable_rx_zero_copy, bool, 0444);
+module_param_named(disable_dim, rtw89_pci_disable_dim, bool, 0444);
+module_param_named(threaded_napi, rtw89_pci_threaded_napi, bool, 0444);
+module_param_named(tx_copybreak, rtw89_pci_tx_copybreak, uint, 0444);
+module_param_named(disable_tx_sg, rtw89_pci_disable_tx_sg, bool, 0444);
+module_param_named(txbd_num, rtw89_pci_txbd_num, uint, 0444);
+module_param_named(rxbd_num, rtw89_pci_rxbd_num, uint, 0444);
+module_param_named(txwd_num, rtw89_pci_txwd_num, uint, 0444);
+module_param_named(disable_dma_arena, rtw89_pci_disable_dma_arena, bool, 0444);
+module_param_named(disable_irq_fast_path, rtw89_pci_disable_irq_fast_path, bool, 0644);
+module_param_named(disable_link_pm, rtw89_pci_disable_link_pm, bool, 0644);
 MODULE_PARM_DESC(disable_clkreq, "Set Y to disable PCI clkreq support");
 MODULE_PARM_DESC(disable_aspm_l1, "Set Y to disable PCI ASPM L1 support");
 MODULE_PARM_DESC(disable_aspm_l1ss, "Set Y to disable PCI L1SS support");
+MODULE_PARM_DESC(disable_rx_zero_copy, "Set Y to disable zero-copy RX with page pool buffers");
+MODULE_PARM_DESC(disable_dim, "Set Y to disable dynamic RX interrupt moderation");
+MODULE_PARM_DESC(threaded_napi, "Set Y to poll RX and TX release in kernel threads");
+MODULE_PARM_DESC(tx_copybreak, "Copy TX frames up to this length (max 256) to pre-mapped buffers instead of mapping them (0: disable)");
+MODULE_PARM_DESC(disable_tx_sg, "Set Y to disable scatter-gather TX of fragmented frames");
+MODULE_PARM_DESC(txbd_num, "Number of TX BDs per DMA channel (32-4095, default 256)");
+MODULE_PARM_DESC(rxbd_num, "Number of RX BDs per DMA channel (32-4095, default 256)");
+MODULE_PARM_DESC(txwd_num, "Number of TX WD pages per DMA channel (32-32767, default 512)");
+MODULE_PARM_DESC(disable_dma_arena, "Set Y to allocate each DMA ring separately instead of from shared arenas");
+MODULE_PARM_DESC(disable_irq_fast_path, "Set Y to always schedule NAPI from the threaded interrupt handler");
+MODULE_PARM_DESC(disable_link_pm, "Set Y to keep ASPM L1/L1SS and LTR enabled regardless of traffic");
 
 static int rtw89_pci_rst_bdram_pcie(struct rtw89_dev *rtwdev)
 {
@@ -58,6 +102,17 @@ static u32 rtw89_pci_dma_recalc(struct rtw89_dev *rtwdev,
 	return cnt;
 }
 
+static u32 rtw89_pci_get_avail_txbd_num(struct rtw89_pci_tx_ring *ring)
+{
+	struct rtw89_pci_dma_ring *bd_ring = &ring->bd_ring;
+
+	/* reserved 1 desc check ring is full or not */
+	if (bd_ring->rp > bd_ring->wp)
+		return bd_ring->rp - bd_ring->wp - 1;
+
+	return bd_ring->len - (bd_ring->wp - bd_ring->rp) - 1;
+}
+
 static u32 rtw89_pci_txbd_recalc(struct rtw89_dev *rtwdev,
 				 struct rtw89_pci_tx_ring *tx_ring)
 {
@@ -65,7 +120,7 @@ static u32 rtw89_pci_txbd_recalc(struct rtw89_dev *rtwdev,
 	u32 addr_idx = bd_ring->addr.idx;
 	u32 cnt, idx;
 
-	idx = rtw89_read32(rtwdev, addr_idx);
+	idx = rtw89_pci_dp_read32(rtwdev, addr_idx);
 	cnt = rtw89_pci_dma_recalc(rtwdev, bd_ring, idx, true);
 
 	return cnt;
@@ -124,12 +179,43 @@ static u32 rtw89_pci_rxbd_recalc(struct rtw89_dev *rtwdev,
 	u32 addr_idx = bd_ring->addr.idx;
 	u32 cnt, idx;
 
-	idx = rtw89_read32(rtwdev, addr_idx);
+	idx = rtw89_pci_dp_read32(rtwdev, addr_idx);
 	cnt = rtw89_pci_dma_recalc(rtwdev, bd_ring, idx, false);
+	rx_ring->bd_hwm = max(rx_ring->bd_hwm, cnt);
 
 	return cnt;
 }
 
+static void rtw89_pci_lock_bh(spinlock_t *lock,
+			      struct rtw89_pci_lock_stats *stats)
+{
+	if (!spin_trylock_bh(lock)) {
+		spin_lock_bh(lock);
+		stats->contended++;
+	}
+	stats->acquired++;
+}
+
+static void rtw89_pci_tx_ring_lock(struct rtw89_pci_tx_ring *tx_ring)
+{
+	rtw89_pci_lock_bh(&tx_ring->lock, &tx_ring->lock_stats);
+}
+
+static void rtw89_pci_tx_ring_unlock(struct rtw89_pci_tx_ring *tx_ring)
+{
+	spin_unlock_bh(&tx_ring->lock);
+}
+
+static void rtw89_pci_rpq_lock(struct rtw89_pci *rtwpci)
+{
+	rtw89_pci_lock_bh(&rtwpci->rpq_lock, &rtwpci->rpq_lock_stats);
+}
+
+static void rtw89_pci_rpq_unlock(struct rtw89_pci *rtwpci)
+{
+	spin_unlock_bh(&rtwpci->rpq_lock);
+}
+
 static void rtw89_pci_sync_skb_for_cpu(struct rtw89_dev *rtwdev,
 				       struct sk_buff *skb)
 {
@@ -154,21 +240,135 @@ static void rtw89_pci_sync_skb_for_device(struct rtw89_dev *rtwdev,
 				   DMA_FROM_DEVICE);
 }
 
-static int rtw89_pci_rxbd_info_update(struct rtw89_dev *rtwdev,
-				      struct sk_buff *skb)
+static void *rtw89_pci_rx_page_data(const struct rtw89_pci_rx_page *rx_page)
 {
-	struct rtw89_pci_rxbd_info *rxbd_info;
-	struct rtw89_pci_rx_info *rx_info = RTW89_PCI_RX_SKB_CB(skb);
+	return page_address(rx_page->page) + RTW89_PCI_RX_PP_HEADROOM;
+}
+
+static u8 *rtw89_pci_sync_rx_buf_for_cpu(struct rtw89_dev *rtwdev,
+					 struct rtw89_pci_rx_ring *rx_ring,
+					 u32 idx)
+{
+	struct rtw89_pci_rx_page *rx_page;
+	struct sk_buff *skb;
+
+	if (rx_ring->page_pool) {
+		rx_page = &rx_ring->pages[idx];
+		dma_sync_single_for_cpu(rtwdev->dev, rx_page->dma,
+					RTW89_PCI_RX_BUF_SIZE, DMA_FROM_DEVICE);
+		return rtw89_pci_rx_page_data(rx_page);
+	}
+
+	skb = rx_ring->buf[idx];
+	rtw89_pci_sync_skb_for_cpu(rtwdev, skb);
+
+	return skb->data;
+}
+
+static void rtw89_pci_sync_rx_buf_for_device(struct rtw89_dev *rtwdev,
+					     struct rtw89_pci_rx_ring *rx_ring,
+					     u32 idx)
+{
+	struct rtw89_pci_rx_page *rx_page;
+
+	if (rx_ring->page_pool) {
+		rx_page = &rx_ring->pages[idx];
+		dma_sync_single_for_device(rtwdev->dev, rx_page->dma,
+					   RTW89_PCI_RX_BUF_SIZE, DMA_FROM_DEVICE);
+		return;
+	}
+
+	rtw89_pci_sync_skb_for_device(rtwdev, rx_ring->buf[idx]);
+}
+
+static void rtw89_pci_parse_rxbd_info(const u8 *data,
+				      struct rtw89_pci_rx_info *rx_info)
+{
+	const struct rtw89_pci_rxbd_info *rxbd_info;
 
-	rxbd_info = (struct rtw89_pci_rxbd_info *)skb->data;
+	rxbd_info = (const struct rtw89_pci_rxbd_info *)data;
 	rx_info->fs = le32_get_bits(rxbd_info->dword, RTW89_PCI_RXBD_FS);
 	rx_info->ls = le32_get_bits(rxbd_info->dword, RTW89_PCI_RXBD_LS);
 	rx_info->len = le32_get_bits(rxbd_info->dword, RTW89_PCI_RXBD_WRITE_SIZE);
 	rx_info->tag = le32_get_bits(rxbd_info->dword, RTW89_PCI_RXBD_TAG);
+}
+
+static int rtw89_pci_rxbd_info_update(struct rtw89_dev *rtwdev,
+				      struct sk_buff *skb)
+{
+	struct rtw89_pci_rx_info *rx_info = RTW89_PCI_RX_SKB_CB(skb);
+
+	rtw89_pci_parse_rxbd_info(skb->data, rx_info);
 
 	return 0;
 }
 
+#ifdef RTW89_PCI_RX_ZERO_COPY
+static void rtw89_pci_init_rx_bd_page(struct rtw89_pci_rx_ring *rx_ring,
+				      struct page *page, u32 idx)
+{
+	struct rtw89_pci_rx_page *rx_page = &rx_ring->pages[idx];
+	struct rtw89_pci_rx_bd_32 *rx_bd = RTW89_PCI_RX_BD(rx_ring, idx);
+
+	rx_page->page = page;
+	rx_page->dma = page_pool_get_dma_addr(page) + RTW89_PCI_RX_PP_HEADROOM;
+
+	memset(rx_bd, 0, sizeof(*rx_bd));
+	rx_bd->buf_size = cpu_to_le16(rx_ring->buf_sz);
+	rx_bd->dma = cpu_to_le32(rx_page->dma);
+}
+
+static struct sk_buff *
+rtw89_pci_rx_page_build_skb(struct rtw89_dev *rtwdev,
+			    struct rtw89_pci_rx_ring *rx_ring, u32 idx,
+			    const struct rtw89_pci_rx_info *rx_info,
+			    const struct rtw89_rx_desc_info *desc_info,
+			    u32 offset)
+{
+	struct page *page = rx_ring->pages[idx].page;
+	struct page *new_page;
+	struct sk_buff *skb;
+	u32 len;
+
+	if (unlikely(offset > rx_info->len))
+		return NULL;
+
+	/* length of a single segment skb is desc_info->pkt_size */
+	len = min_t(u32, rx_info->len - offset, desc_info->pkt_size);
+
+	/* Get the refill page in advance, so the frame can still be copied
+	 * out of the current page if the pool runs dry.
+	 */
+	new_page = page_pool_dev_alloc_pages(rx_ring->page_pool);
+	if (!new_page)
+		return NULL;
+
+	skb = build_skb(page_address(page), PAGE_SIZE << RTW89_PCI_RX_PP_ORDER);
+	if (!skb) {
+		page_pool_put_full_page(rx_ring->page_pool, new_page, false);
+		return NULL;
+	}
+
+	skb_reserve(skb, RTW89_PCI_RX_PP_HEADROOM + offset);
+	skb_put(skb, len);
+	skb_mark_for_recycle(skb);
+
+	rtw89_pci_init_rx_bd_page(rx_ring, new_page, idx);
+
+	return skb;
+}
+#else
+static struct sk_buff *
+rtw89_pci_rx_page_build_skb(struct rtw89_dev *rtwdev,
+			    struct rtw89_pci_rx_ring *rx_ring, u32 idx,
+			    const struct rtw89_pci_rx_info *rx_info,
+			    const struct rtw89_rx_desc_info *desc_info,
+			    u32 offset)
+{
+	return NULL;
+}
+#endif
+
 static void rtw89_pci_ctrl_txdma_ch_pcie(struct rtw89_dev *rtwdev, bool enable)
 {
 	const struct rtw89_pci_info *info = rtwdev->pci_info;
@@ -200,7 +400,7 @@ static void rtw89_pci_ctrl_txdma_fw_ch_pcie(struct rtw89_dev *rtwdev, bool enabl
 static bool
 rtw89_skb_put_rx_data(struct rtw89_dev *rtwdev, bool fs, bool ls,
 		      struct sk_buff *new,
-		      const struct sk_buff *skb, u32 offset,
+		      const u8 *data, u32 offset,
 		      const struct rtw89_pci_rx_info *rx_info,
 		      const struct rtw89_rx_desc_info *desc_info)
 {
@@ -211,7 +411,7 @@ rtw89_skb_put_rx_data(struct rtw89_dev *rtwdev, bool fs, bool ls,
 			    "invalid rx data length bd_len=%d desc_len=%d offset=%d (fs=%d ls=%d)\n",
 			    rx_info->len, desc_info->pkt_size, offset, fs, ls);
 		rtw89_hex_dump(rtwdev, RTW89_DBG_TXRX, "rx_data: ",
-			       skb->data, rx_info->len);
+			       data, rx_info->len);
 		/* length of a single segment skb is desc_info->pkt_size */
 		if (fs && ls) {
 			copy_len = desc_info->pkt_size;
@@ -221,7 +421,7 @@ rtw89_skb_put_rx_data(struct rtw89_dev *rtwdev, bool fs, bool ls,
 		}
 	}
 
-	skb_put_data(new, skb->data + offset, copy_len);
+	skb_put_data(new, data + offset, copy_len);
 
 	return true;
 }
@@ -230,29 +430,21 @@ static u32 rtw89_pci_rxbd_deliver_skbs(struct rtw89_dev *rtwdev,
 				       struct rtw89_pci_rx_ring *rx_ring)
 {
 	struct rtw89_pci_dma_ring *bd_ring = &rx_ring->bd_ring;
-	struct rtw89_pci_rx_info *rx_info;
+	struct rtw89_pci_rx_info rx_info = {};
 	struct rtw89_rx_desc_info *desc_info = &rx_ring->diliver_desc;
 	struct sk_buff *new = rx_ring->diliver_skb;
-	struct sk_buff *skb;
 	u32 rxinfo_size = sizeof(struct rtw89_pci_rxbd_info);
+	u32 idx = bd_ring->wp;
 	u32 offset;
 	u32 cnt = 1;
 	bool fs, ls;
-	int ret;
+	u8 *data;
 
-	skb = rx_ring->buf[bd_ring->wp];
-	rtw89_pci_sync_skb_for_cpu(rtwdev, skb);
-
-	ret = rtw89_pci_rxbd_info_update(rtwdev, skb);
-	if (ret) {
-		rtw89_err(rtwdev, "failed to update %d RXBD info: %d\n",
-			  bd_ring->wp, ret);
-		goto err_sync_device;
-	}
+	data = rtw89_pci_sync_rx_buf_for_cpu(rtwdev, rx_ring, idx);
+	rtw89_pci_parse_rxbd_info(data, &rx_info);
 
-	rx_info = RTW89_PCI_RX_SKB_CB(skb);
-	fs = rx_info->fs;
-	ls = rx_info->ls;
+	fs = rx_info.fs;
+	ls = rx_info.ls;
 
 	if (fs) {
 		if (new) {
@@ -265,16 +457,31 @@ static u32 rtw89_pci_rxbd_deliver_skbs(struct rtw89_dev *rtwdev,
 			goto err_sync_device;
 		}
 
-		rtw89_chip_query_rxdesc(rtwdev, desc_info, skb->data, rxinfo_size);
+		rtw89_chip_query_rxdesc(rtwdev, desc_info, data, rxinfo_size);
+
+		/* first segment has RX desc */
+		offset = desc_info->offset + desc_info->rxd_len;
+
+		/* single segment frame in a page can be passed up without copy */
+		if (ls && rx_ring->page_pool) {
+			new = rtw89_pci_rx_page_build_skb(rtwdev, rx_ring, idx,
+							  &rx_info, desc_info,
+							  offset);
+			if (new) {
+				rtw89_pci_rxbd_increase(rx_ring, 1);
+				rx_ring->rx_zero_copy++;
+				rx_ring->rx_bytes += new->len;
+				rtw89_core_rx(rtwdev, desc_info, new);
+				desc_info->ready = false;
+				return cnt;
+			}
+		}
 
 		new = rtw89_alloc_skb_for_rx(rtwdev, desc_info->pkt_size);
 		if (!new)
 			goto err_sync_device;
 
 		rx_ring->diliver_skb = new;
-
-		/* first segment has RX desc */
-		offset = desc_info->offset + desc_info->rxd_len;
 	} else {
 		offset = sizeof(struct rtw89_pci_rxbd_info);
 		if (!new) {
@@ -282,9 +489,9 @@ static u32 rtw89_pci_rxbd_deliver_skbs(struct rtw89_dev *rtwdev,
 			goto err_sync_device;
 		}
 	}
-	if (!rtw89_skb_put_rx_data(rtwdev, fs, ls, new, skb, offset, rx_info, desc_info))
+	if (!rtw89_skb_put_rx_data(rtwdev, fs, ls, new, data, offset, &rx_info, desc_info))
 		goto err_sync_device;
-	rtw89_pci_sync_skb_for_device(rtwdev, skb);
+	rtw89_pci_sync_rx_buf_for_device(rtwdev, rx_ring, idx);
 	rtw89_pci_rxbd_increase(rx_ring, 1);
 
 	if (!desc_info->ready) {
@@ -292,6 +499,8 @@ static u32 rtw89_pci_rxbd_deliver_skbs(struct rtw89_dev *rtwdev,
 		goto err_free_resource;
 	}
 	if (ls) {
+		rx_ring->rx_copied++;
+		rx_ring->rx_bytes += new->len;
 		rtw89_core_rx(rtwdev, desc_info, new);
 		rx_ring->diliver_skb = NULL;
 		desc_info->ready = false;
@@ -300,7 +509,7 @@ static u32 rtw89_pci_rxbd_deliver_skbs(struct rtw89_dev *rtwdev,
 	return cnt;
 
 err_sync_device:
-	rtw89_pci_sync_skb_for_device(rtwdev, skb);
+	rtw89_pci_sync_rx_buf_for_device(rtwdev, rx_ring, idx);
 	rtw89_pci_rxbd_increase(rx_ring, 1);
 err_free_resource:
 	if (new)
@@ -331,7 +540,7 @@ static void rtw89_pci_rxbd_deliver(struct rtw89_dev *rtwdev,
 		cnt -= rx_cnt;
 	}
 
-	rtw89_write16(rtwdev, bd_ring->addr.idx, bd_ring->wp);
+	rtw89_pci_dp_write16(rtwdev, bd_ring->addr.idx, bd_ring->wp);
 }
 
 static int rtw89_pci_poll_rxq_dma(struct rtw89_dev *rtwdev,
@@ -343,13 +552,18 @@ static int rtw89_pci_poll_rxq_dma(struct rtw89_dev *rtwdev,
 
 	rx_ring = &rtwpci->rx_rings[RTW89_RXCH_RXQ];
 
-	cnt = rtw89_pci_rxbd_recalc(rtwdev, rx_ring);
-	if (!cnt)
-		return 0;
+	/* always close the batch, which also flushes frames that timed out
+	 * waiting for PPDU status
+	 */
+	rtw89_core_rx_batch_begin(rtwdev);
 
-	cnt = min_t(u32, budget, cnt);
+	cnt = rtw89_pci_rxbd_recalc(rtwdev, rx_ring);
+	if (cnt) {
+		cnt = min_t(u32, budget, cnt);
+		rtw89_pci_rxbd_deliver(rtwdev, rx_ring, cnt);
+	}
 
-	rtw89_pci_rxbd_deliver(rtwdev, rx_ring, cnt);
+	rtw89_core_rx_batch_end(rtwdev);
 
 	/* In case of flushing pending SKBs, the countdown may exceed. */
 	if (rtwdev->napi_budget_countdown <= 0)
@@ -360,7 +574,8 @@ static int rtw89_pci_poll_rxq_dma(struct rtw89_dev *rtwdev,
 
 static void rtw89_pci_tx_status(struct rtw89_dev *rtwdev,
 				struct rtw89_pci_tx_ring *tx_ring,
-				struct sk_buff *skb, u8 tx_status)
+				struct sk_buff *skb, u8 tx_status,
+				struct sk_buff_head *done)
 {
 	struct rtw89_tx_skb_data *skb_data = RTW89_TX_SKB_CB(skb);
 	struct ieee80211_tx_info *info;
@@ -370,6 +585,13 @@ static void rtw89_pci_tx_status(struct rtw89_dev *rtwdev,
 	info = IEEE80211_SKB_CB(skb);
 	ieee80211_tx_info_clear_status(info);
 
+	/* RPP doesn't carry rate and retry count, so report a single attempt
+	 * and let rtw89_pci_tx_status_report() fill the rate from RA report.
+	 */
+	info->status.rates[0].idx = -1;
+	info->status.rates[0].count = tx_status == RTW89_TX_DONE ||
+				      tx_status == RTW89_TX_RETRY_LIMIT;
+
 	if (info->flags & IEEE80211_TX_CTL_NO_ACK)
 		info->flags |= IEEE80211_TX_STAT_NOACK_TRANSMITTED;
 	if (tx_status == RTW89_TX_DONE) {
@@ -395,15 +617,142 @@ static void rtw89_pci_tx_status(struct rtw89_dev *rtwdev,
 		}
 	}
 
-	ieee80211_tx_status_ni(rtwdev->hw, skb);
+	__skb_queue_tail(done, skb);
+}
+
+/* Return airtime in us used by the skb, estimated from RA report */
+static u32 rtw89_pci_tx_status_rate(struct rtw89_sta *rtwsta,
+				    struct sk_buff *skb)
+{
+	struct ieee80211_tx_info *info = IEEE80211_SKB_CB(skb);
+	struct ieee80211_tx_rate *rate = &info->status.rates[0];
+	const struct rtw89_ra_report *ra_report = &rtwsta->ra_report;
+	const struct rate_info *txrate = &ra_report->txrate;
+	u32 tx_time;
+
+	if (!rate->count || !ra_report->bit_rate)
+		return 0;
+
+	/* bit_rate is in unit of 100 kbps */
+	tx_time = DIV_ROUND_UP(skb->len * 80, ra_report->bit_rate) * rate->count;
+
+	/* legacy and HE rates can't be described by ieee80211_tx_rate */
+	if (txrate->flags & RATE_INFO_FLAGS_MCS) {
+		rate->idx = txrate->mcs;
+		rate->flags = IEEE80211_TX_RC_MCS;
+	} else if (txrate->flags & RATE_INFO_FLAGS_VHT_MCS) {
+		ieee80211_rate_set_vht(rate, txrate->mcs, txrate->nss);
+		rate->flags = IEEE80211_TX_RC_VHT_MCS;
+	} else {
+		return tx_time;
+	}
+
+	if (txrate->flags & RATE_INFO_FLAGS_SHORT_GI)
+		rate->flags |= IEEE80211_TX_RC_SHORT_GI;
+
+	switch (txrate->bw) {
+	case RATE_INFO_BW_40:
+		rate->flags |= IEEE80211_TX_RC_40_MHZ_WIDTH;
+		break;
+	case RATE_INFO_BW_80:
+		rate->flags |= IEEE80211_TX_RC_80_MHZ_WIDTH;
+		break;
+	case RATE_INFO_BW_160:
+		rate->flags |= IEEE80211_TX_RC_160_MHZ_WIDTH;
+		break;
+	default:
+		break;
+	}
+
+	return tx_time;
+}
+
+/* Report TX status of skbs released by a batch of RPP in one BH section,
+ * after the locks of TX rings and RPQ are dropped.
+ */
+static void rtw89_pci_tx_status_report(struct rtw89_dev *rtwdev,
+				       struct sk_buff_head *done)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	struct ieee80211_sta *airtime_sta = NULL;
+	struct ieee80211_tx_status status;
+	struct ieee80211_sta *sta = NULL;
+	struct rtw89_sta *rtwsta;
+	struct ieee80211_hdr *hdr;
+	struct sk_buff *skb;
+	u8 airtime_tid = 0;
+	u32 airtime = 0;
+	u32 tx_time;
+	u8 tid;
+
+	if (skb_queue_empty(done))
+		return;
+
+	rtwpci->tx_status_batches++;
+	rtwpci->tx_status_reported += skb_queue_len(done);
+
+	local_bh_disable();
+	rcu_read_lock();
+
+	while ((skb = __skb_dequeue(done))) {
+		hdr = (struct ieee80211_hdr *)skb->data;
+		if (!sta || !ether_addr_equal(sta->addr, hdr->addr1))
+			sta = ieee80211_find_sta_by_ifaddr(rtwdev->hw, hdr->addr1,
+							   NULL);
+
+		status = (struct ieee80211_tx_status) {
+			.sta = sta,
+			.info = IEEE80211_SKB_CB(skb),
+			.skb = skb,
+		};
+
+		if (!sta)
+			goto report;
+
+		rtwsta = (struct rtw89_sta *)sta->drv_priv;
+		rtw89_core_sta_airtime_release(rtwdev, rtwsta, skb);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 10, 0)
+		/* AQL estimates airtime of next frames by the reported rate */
+		if (rtwsta->ra_report.bit_rate)
+			status.rate = &rtwsta->ra_report.txrate;
+#endif
+
+		tx_time = rtw89_pci_tx_status_rate(rtwsta, skb);
+		if (!tx_time || !ieee80211_is_data_qos(hdr->frame_control))
+			goto report;
+
+		/* register airtime once per run of frames of the same TID */
+		tid = ieee80211_get_tid(hdr);
+		if (airtime && (airtime_sta != sta || airtime_tid != tid)) {
+			ieee80211_sta_register_airtime(airtime_sta, airtime_tid,
+						       airtime, 0);
+			airtime = 0;
+		}
+		airtime_sta = sta;
+		airtime_tid = tid;
+		airtime += tx_time;
+report:
+		ieee80211_tx_status_ext(rtwdev->hw, &status);
+	}
+
+	if (airtime)
+		ieee80211_sta_register_airtime(airtime_sta, airtime_tid, airtime, 0);
+
+	rcu_read_unlock();
+	local_bh_enable();
 }
 
 static void rtw89_pci_reclaim_txbd(struct rtw89_dev *rtwdev, struct rtw89_pci_tx_ring *tx_ring)
 {
 	struct rtw89_pci_tx_wd *txwd;
-	u32 cnt;
+	u32 cnt, pending;
 
 	cnt = rtw89_pci_txbd_recalc(rtwdev, tx_ring);
+
+	/* BDs not yet fetched by hardware */
+	pending = tx_ring->bd_ring.len - 1 - rtw89_pci_get_avail_txbd_num(tx_ring);
+	tx_ring->bd_hwm = max(tx_ring->bd_hwm, pending);
+
 	while (cnt--) {
 		txwd = list_first_entry_or_null(&tx_ring->busy_pages, struct rtw89_pci_tx_wd, list);
 		if (!txwd) {
@@ -435,10 +784,80 @@ static void rtw89_pci_release_busy_txwd(struct rtw89_dev *rtwdev,
 	}
 }
 
+static dma_addr_t *rtw89_pci_txwd_frag_dma(struct rtw89_pci_tx_wd_ring *wd_ring,
+					    struct rtw89_pci_tx_wd *txwd)
+{
+	return &wd_ring->frag_dma[txwd->seq * RTW89_PCI_TX_FRAG_MAX];
+}
+
+static void rtw89_pci_tx_unmap_skb(struct rtw89_dev *rtwdev,
+				   struct rtw89_pci_tx_wd_ring *wd_ring,
+				   struct rtw89_pci_tx_wd *txwd,
+				   struct sk_buff *skb, dma_addr_t dma)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	struct device *dev = &rtwpci->pdev->dev;
+	dma_addr_t *frag_dma = rtw89_pci_txwd_frag_dma(wd_ring, txwd);
+	int i;
+
+	for (i = 0; i < txwd->nr_frags; i++)
+		dma_unmap_page(dev, frag_dma[i],
+			       skb_frag_size(&skb_shinfo(skb)->frags[i]),
+			       DMA_TO_DEVICE);
+	txwd->nr_frags = 0;
+
+	dma_unmap_single(dev, dma, skb_headlen(skb), DMA_TO_DEVICE);
+}
+
+static int rtw89_pci_tx_map_skb(struct rtw89_dev *rtwdev,
+				struct rtw89_pci_tx_wd_ring *wd_ring,
+				struct rtw89_pci_tx_wd *txwd,
+				struct sk_buff *skb,
+				struct rtw89_pci_tx_seg *segs, u8 *seg_num)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	struct device *dev = &rtwpci->pdev->dev;
+	dma_addr_t *frag_dma = rtw89_pci_txwd_frag_dma(wd_ring, txwd);
+	u8 nr_frags = skb_shinfo(skb)->nr_frags;
+	const skb_frag_t *frag;
+	dma_addr_t dma;
+	int i;
+
+	dma = dma_map_single(dev, skb->data, skb_headlen(skb), DMA_TO_DEVICE);
+	if (dma_mapping_error(dev, dma))
+		return -EBUSY;
+
+	segs[0].dma = dma;
+	segs[0].len = skb_headlen(skb);
+
+	for (i = 0; i < nr_frags; i++) {
+		frag = &skb_shinfo(skb)->frags[i];
+		dma = skb_frag_dma_map(dev, frag, 0, skb_frag_size(frag),
+				       DMA_TO_DEVICE);
+		if (dma_mapping_error(dev, dma))
+			goto err_unmap;
+
+		frag_dma[i] = dma;
+		segs[i + 1].dma = dma;
+		segs[i + 1].len = skb_frag_size(frag);
+	}
+
+	txwd->nr_frags = nr_frags;
+	*seg_num = nr_frags + 1;
+
+	return 0;
+
+err_unmap:
+	txwd->nr_frags = i;
+	rtw89_pci_tx_unmap_skb(rtwdev, wd_ring, txwd, skb, segs[0].dma);
+
+	return -EBUSY;
+}
+
 static void rtw89_pci_release_txwd_skb(struct rtw89_dev *rtwdev,
 				       struct rtw89_pci_tx_ring *tx_ring,
 				       struct rtw89_pci_tx_wd *txwd, u16 seq,
-				       u8 tx_status)
+				       u8 tx_status, struct sk_buff_head *done)
 {
 	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
 	struct rtw89_pci_tx_data *tx_data;
@@ -459,18 +878,21 @@ static void rtw89_pci_release_txwd_skb(struct rtw89_dev *rtwdev,
 		skb_unlink(skb, &txwd->queue);
 
 		tx_data = RTW89_PCI_TX_SKB_CB(skb);
-		dma_unmap_single(&rtwpci->pdev->dev, tx_data->dma, skb->len,
-				 DMA_TO_DEVICE);
+		if (!txwd->copied)
+			rtw89_pci_tx_unmap_skb(rtwdev, &tx_ring->wd_ring, txwd,
+					       skb, tx_data->dma);
 
-		rtw89_pci_tx_status(rtwdev, tx_ring, skb, tx_status);
+		rtw89_pci_tx_status(rtwdev, tx_ring, skb, tx_status, done);
 	}
+	txwd->copied = false;
 
 	if (list_empty(&txwd->list))
 		rtw89_pci_enqueue_txwd(tx_ring, txwd);
 }
 
 static void rtw89_pci_release_rpp(struct rtw89_dev *rtwdev,
-				  struct rtw89_pci_rpp_fmt *rpp)
+				  struct rtw89_pci_rpp_fmt *rpp,
+				  struct sk_buff_head *done)
 {
 	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
 	struct rtw89_pci_tx_ring *tx_ring;
@@ -493,11 +915,14 @@ static void rtw89_pci_release_rpp(struct rtw89_dev *rtwdev,
 	wd_ring = &tx_ring->wd_ring;
 	txwd = &wd_ring->pages[seq];
 
-	rtw89_pci_release_txwd_skb(rtwdev, tx_ring, txwd, seq, tx_status);
+	rtw89_pci_tx_ring_lock(tx_ring);
+	rtw89_pci_release_txwd_skb(rtwdev, tx_ring, txwd, seq, tx_status, done);
+	rtw89_pci_tx_ring_unlock(tx_ring);
 }
 
 static void rtw89_pci_release_pending_txwd_skb(struct rtw89_dev *rtwdev,
-					       struct rtw89_pci_tx_ring *tx_ring)
+					       struct rtw89_pci_tx_ring *tx_ring,
+					       struct sk_buff_head *done)
 {
 	struct rtw89_pci_tx_wd_ring *wd_ring = &tx_ring->wd_ring;
 	struct rtw89_pci_tx_wd *txwd;
@@ -509,13 +934,14 @@ static void rtw89_pci_release_pending_txwd_skb(struct rtw89_dev *rtwdev,
 		if (!list_empty(&txwd->list))
 			continue;
 
-		rtw89_pci_release_txwd_skb(rtwdev, tx_ring, txwd, i, RTW89_TX_MACID_DROP);
+		rtw89_pci_release_txwd_skb(rtwdev, tx_ring, txwd, i,
+					   RTW89_TX_MACID_DROP, done);
 	}
 }
 
 static u32 rtw89_pci_release_tx_skbs(struct rtw89_dev *rtwdev,
 				     struct rtw89_pci_rx_ring *rx_ring,
-				     u32 max_cnt)
+				     u32 max_cnt, struct sk_buff_head *done)
 {
 	struct rtw89_pci_dma_ring *bd_ring = &rx_ring->bd_ring;
 	struct rtw89_pci_rx_info *rx_info;
@@ -550,7 +976,7 @@ static u32 rtw89_pci_release_tx_skbs(struct rtw89_dev *rtwdev,
 	offset = desc_info.offset + desc_info.rxd_len;
 	for (; offset + rpp_size <= rx_info->len; offset += rpp_size) {
 		rpp = (struct rtw89_pci_rpp_fmt *)(skb->data + offset);
-		rtw89_pci_release_rpp(rtwdev, rpp);
+		rtw89_pci_release_rpp(rtwdev, rpp, done);
 	}
 
 	rtw89_pci_sync_skb_for_device(rtwdev, skb);
@@ -566,13 +992,13 @@ err_sync_device:
 
 static void rtw89_pci_release_tx(struct rtw89_dev *rtwdev,
 				 struct rtw89_pci_rx_ring *rx_ring,
-				 u32 cnt)
+				 u32 cnt, struct sk_buff_head *done)
 {
 	struct rtw89_pci_dma_ring *bd_ring = &rx_ring->bd_ring;
 	u32 release_cnt;
 
 	while (cnt) {
-		release_cnt = rtw89_pci_release_tx_skbs(rtwdev, rx_ring, cnt);
+		release_cnt = rtw89_pci_release_tx_skbs(rtwdev, rx_ring, cnt, done);
 		if (!release_cnt) {
 			rtw89_err(rtwdev, "failed to release TX skbs\n");
 
@@ -584,32 +1010,35 @@ static void rtw89_pci_release_tx(struct rtw89_dev *rtwdev,
 		cnt -= release_cnt;
 	}
 
-	rtw89_write16(rtwdev, bd_ring->addr.idx, bd_ring->wp);
+	rtw89_pci_dp_write16(rtwdev, bd_ring->addr.idx, bd_ring->wp);
 }
 
 static int rtw89_pci_poll_rpq_dma(struct rtw89_dev *rtwdev,
 				  struct rtw89_pci *rtwpci, int budget)
 {
 	struct rtw89_pci_rx_ring *rx_ring;
+	struct sk_buff_head done;
 	u32 cnt;
 	int work_done;
 
 	rx_ring = &rtwpci->rx_rings[RTW89_RXCH_RPQ];
+	__skb_queue_head_init(&done);
 
-	spin_lock_bh(&rtwpci->trx_lock);
+	rtw89_pci_rpq_lock(rtwpci);
 
 	cnt = rtw89_pci_rxbd_recalc(rtwdev, rx_ring);
 	if (cnt == 0)
 		goto out_unlock;
 
-	rtw89_pci_release_tx(rtwdev, rx_ring, cnt);
+	rtw89_pci_release_tx(rtwdev, rx_ring, cnt, &done);
 
 out_unlock:
-	spin_unlock_bh(&rtwpci->trx_lock);
+	rtw89_pci_rpq_unlock(rtwpci);
+
+	rtw89_pci_tx_status_report(rtwdev, &done);
 
 	/* always release all RPQ */
 	work_done = min_t(int, cnt, budget);
-	rtwdev->napi_budget_countdown -= work_done;
 
 	return work_done;
 }
@@ -645,13 +1074,13 @@ void rtw89_pci_recognize_intrs(struct rtw89_dev *rtwdev,
 			       struct rtw89_pci *rtwpci,
 			       struct rtw89_pci_isrs *isrs)
 {
-	isrs->halt_c2h_isrs = rtw89_read32(rtwdev, R_AX_HISR0) & rtwpci->halt_c2h_intrs;
-	isrs->isrs[0] = rtw89_read32(rtwdev, R_AX_PCIE_HISR00) & rtwpci->intrs[0];
-	isrs->isrs[1] = rtw89_read32(rtwdev, R_AX_PCIE_HISR10) & rtwpci->intrs[1];
+	isrs->halt_c2h_isrs = rtw89_pci_dp_read32(rtwdev, R_AX_HISR0) & rtwpci->halt_c2h_intrs;
+	isrs->isrs[0] = rtw89_pci_dp_read32(rtwdev, R_AX_PCIE_HISR00) & rtwpci->intrs[0];
+	isrs->isrs[1] = rtw89_pci_dp_read32(rtwdev, R_AX_PCIE_HISR10) & rtwpci->intrs[1];
 
-	rtw89_write32(rtwdev, R_AX_HISR0, isrs->halt_c2h_isrs);
-	rtw89_write32(rtwdev, R_AX_PCIE_HISR00, isrs->isrs[0]);
-	rtw89_write32(rtwdev, R_AX_PCIE_HISR10, isrs->isrs[1]);
+	rtw89_pci_dp_write32(rtwdev, R_AX_HISR0, isrs->halt_c2h_isrs);
+	rtw89_pci_dp_write32(rtwdev, R_AX_PCIE_HISR00, isrs->isrs[0]);
+	rtw89_pci_dp_write32(rtwdev, R_AX_PCIE_HISR10, isrs->isrs[1]);
 }
 EXPORT_SYMBOL(rtw89_pci_recognize_intrs);
 
@@ -659,57 +1088,57 @@ void rtw89_pci_recognize_intrs_v1(struct rtw89_dev *rtwdev,
 				  struct rtw89_pci *rtwpci,
 				  struct rtw89_pci_isrs *isrs)
 {
-	isrs->ind_isrs = rtw89_read32(rtwdev, R_AX_PCIE_HISR00_V1) & rtwpci->ind_intrs;
+	isrs->ind_isrs = rtw89_pci_dp_read32(rtwdev, R_AX_PCIE_HISR00_V1) & rtwpci->ind_intrs;
 	isrs->halt_c2h_isrs = isrs->ind_isrs & B_AX_HS0ISR_IND_INT_EN ?
-			      rtw89_read32(rtwdev, R_AX_HISR0) & rtwpci->halt_c2h_intrs : 0;
+			      rtw89_pci_dp_read32(rtwdev, R_AX_HISR0) & rtwpci->halt_c2h_intrs : 0;
 	isrs->isrs[0] = isrs->ind_isrs & B_AX_HCI_AXIDMA_INT_EN ?
-			rtw89_read32(rtwdev, R_AX_HAXI_HISR00) & rtwpci->intrs[0] : 0;
+			rtw89_pci_dp_read32(rtwdev, R_AX_HAXI_HISR00) & rtwpci->intrs[0] : 0;
 	isrs->isrs[1] = isrs->ind_isrs & B_AX_HS1ISR_IND_INT_EN ?
-			rtw89_read32(rtwdev, R_AX_HISR1) & rtwpci->intrs[1] : 0;
+			rtw89_pci_dp_read32(rtwdev, R_AX_HISR1) & rtwpci->intrs[1] : 0;
 
 	if (isrs->halt_c2h_isrs)
-		rtw89_write32(rtwdev, R_AX_HISR0, isrs->halt_c2h_isrs);
+		rtw89_pci_dp_write32(rtwdev, R_AX_HISR0, isrs->halt_c2h_isrs);
 	if (isrs->isrs[0])
-		rtw89_write32(rtwdev, R_AX_HAXI_HISR00, isrs->isrs[0]);
+		rtw89_pci_dp_write32(rtwdev, R_AX_HAXI_HISR00, isrs->isrs[0]);
 	if (isrs->isrs[1])
-		rtw89_write32(rtwdev, R_AX_HISR1, isrs->isrs[1]);
+		rtw89_pci_dp_write32(rtwdev, R_AX_HISR1, isrs->isrs[1]);
 }
 EXPORT_SYMBOL(rtw89_pci_recognize_intrs_v1);
 
 static void rtw89_pci_clear_isr0(struct rtw89_dev *rtwdev, u32 isr00)
 {
 	/* write 1 clear */
-	rtw89_write32(rtwdev, R_AX_PCIE_HISR00, isr00);
+	rtw89_pci_dp_write32(rtwdev, R_AX_PCIE_HISR00, isr00);
 }
 
 void rtw89_pci_enable_intr(struct rtw89_dev *rtwdev, struct rtw89_pci *rtwpci)
 {
-	rtw89_write32(rtwdev, R_AX_HIMR0, rtwpci->halt_c2h_intrs);
-	rtw89_write32(rtwdev, R_AX_PCIE_HIMR00, rtwpci->intrs[0]);
-	rtw89_write32(rtwdev, R_AX_PCIE_HIMR10, rtwpci->intrs[1]);
+	rtw89_pci_dp_write32(rtwdev, R_AX_HIMR0, rtwpci->halt_c2h_intrs);
+	rtw89_pci_dp_write32(rtwdev, R_AX_PCIE_HIMR00, rtwpci->intrs[0]);
+	rtw89_pci_dp_write32(rtwdev, R_AX_PCIE_HIMR10, rtwpci->intrs[1]);
 }
 EXPORT_SYMBOL(rtw89_pci_enable_intr);
 
 void rtw89_pci_disable_intr(struct rtw89_dev *rtwdev, struct rtw89_pci *rtwpci)
 {
-	rtw89_write32(rtwdev, R_AX_HIMR0, 0);
-	rtw89_write32(rtwdev, R_AX_PCIE_HIMR00, 0);
-	rtw89_write32(rtwdev, R_AX_PCIE_HIMR10, 0);
+	rtw89_pci_dp_write32(rtwdev, R_AX_HIMR0, 0);
+	rtw89_pci_dp_write32(rtwdev, R_AX_PCIE_HIMR00, 0);
+	rtw89_pci_dp_write32(rtwdev, R_AX_PCIE_HIMR10, 0);
 }
 EXPORT_SYMBOL(rtw89_pci_disable_intr);
 
 void rtw89_pci_enable_intr_v1(struct rtw89_dev *rtwdev, struct rtw89_pci *rtwpci)
 {
-	rtw89_write32(rtwdev, R_AX_PCIE_HIMR00_V1, rtwpci->ind_intrs);
-	rtw89_write32(rtwdev, R_AX_HIMR0, rtwpci->halt_c2h_intrs);
-	rtw89_write32(rtwdev, R_AX_HAXI_HIMR00, rtwpci->intrs[0]);
-	rtw89_write32(rtwdev, R_AX_HIMR1, rtwpci->intrs[1]);
+	rtw89_pci_dp_write32(rtwdev, R_AX_PCIE_HIMR00_V1, rtwpci->ind_intrs);
+	rtw89_pci_dp_write32(rtwdev, R_AX_HIMR0, rtwpci->halt_c2h_intrs);
+	rtw89_pci_dp_write32(rtwdev, R_AX_HAXI_HIMR00, rtwpci->intrs[0]);
+	rtw89_pci_dp_write32(rtwdev, R_AX_HIMR1, rtwpci->intrs[1]);
 }
 EXPORT_SYMBOL(rtw89_pci_enable_intr_v1);
 
 void rtw89_pci_disable_intr_v1(struct rtw89_dev *rtwdev, struct rtw89_pci *rtwpci)
 {
-	rtw89_write32(rtwdev, R_AX_PCIE_HIMR00_V1, 0);
+	rtw89_pci_dp_write32(rtwdev, R_AX_PCIE_HIMR00_V1, 0);
 }
 EXPORT_SYMBOL(rtw89_pci_disable_intr_v1);
 
@@ -737,16 +1166,81 @@ static void rtw89_pci_ops_recovery_complete(struct rtw89_dev *rtwdev)
 	spin_unlock_irqrestore(&rtwpci->irq_lock, flags);
 }
 
-static void rtw89_pci_low_power_interrupt_handler(struct rtw89_dev *rtwdev)
+static u8 rtw89_pci_napi_pending(struct rtw89_pci *rtwpci,
+				 const struct rtw89_pci_isrs *isrs)
 {
-	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
-	int budget = NAPI_POLL_WEIGHT;
+	u8 pending = 0;
 
-	/* To prevent RXQ get stuck due to run out of budget. */
-	rtwdev->napi_budget_countdown = budget;
+	/* RX and RPQ interrupts are masked in low power mode, so poll both
+	 * on any interrupt to catch up the traffic while waking up.
+	 */
+	if (rtwpci->low_power)
+		return RTW89_PCI_NAPI_RX | RTW89_PCI_NAPI_TX;
+
+	if (isrs->isrs[0] & (B_AX_RPQDMA_INT | B_AX_RPQBD_FULL_INT))
+		pending |= RTW89_PCI_NAPI_TX;
+	if (isrs->isrs[0] & (B_AX_RXP1DMA_INT | B_AX_RXDMA_INT | B_AX_RDU_INT))
+		pending |= RTW89_PCI_NAPI_RX;
+
+	/* interrupts are enabled by RX NAPI if nothing is going to be polled */
+	if (!pending)
+		pending = RTW89_PCI_NAPI_RX;
+
+	return pending;
+}
+
+static void rtw89_pci_irq_lat_mark(struct rtw89_pci *rtwpci, u8 pending,
+				   enum rtw89_pci_irq_path path)
+{
+	struct rtw89_pci_irq_lat *lat = &rtwpci->irq_lat;
+
+	lat->irqs[path]++;
+
+	/* keep the earliest IRQ if NAPI is scheduled but not polled yet */
+	if (pending & RTW89_PCI_NAPI_RX && !READ_ONCE(lat->rx.sched_ns)) {
+		lat->rx.path = path;
+		WRITE_ONCE(lat->rx.sched_ns, lat->hardirq_ns);
+	}
+	if (pending & RTW89_PCI_NAPI_TX && !READ_ONCE(lat->tx.sched_ns)) {
+		lat->tx.path = path;
+		WRITE_ONCE(lat->tx.sched_ns, lat->hardirq_ns);
+	}
+}
+
+static void rtw89_pci_irq_lat_record(struct rtw89_pci_irq_lat_napi *napi_lat)
+{
+	u64 sched_ns = READ_ONCE(napi_lat->sched_ns);
+	u32 delta_us;
+	u8 idx;
+
+	if (!sched_ns)
+		return;
+
+	delta_us = div_u64(ktime_get_ns() - sched_ns, NSEC_PER_USEC);
+	idx = min_t(u8, fls(delta_us), RTW89_PCI_IRQ_LAT_HIST_NUM - 1);
+	napi_lat->hist[napi_lat->path][idx]++;
+	WRITE_ONCE(napi_lat->sched_ns, 0);
+}
+
+static void rtw89_pci_napi_schedule(struct rtw89_dev *rtwdev,
+				    struct rtw89_pci *rtwpci,
+				    const struct rtw89_pci_isrs *isrs)
+{
+	unsigned long flags;
+	u8 pending;
 
-	rtw89_pci_poll_rpq_dma(rtwdev, rtwpci, budget);
-	rtw89_pci_poll_rxq_dma(rtwdev, rtwpci, budget);
+	spin_lock_irqsave(&rtwpci->irq_lock, flags);
+	pending = rtw89_pci_napi_pending(rtwpci, isrs);
+	rtwpci->napi_pending |= pending;
+	rtw89_pci_irq_lat_mark(rtwpci, pending, RTW89_PCI_IRQ_PATH_THREAD);
+	spin_unlock_irqrestore(&rtwpci->irq_lock, flags);
+
+	local_bh_disable();
+	if (pending & RTW89_PCI_NAPI_RX)
+		napi_schedule(&rtwdev->napi);
+	if (pending & RTW89_PCI_NAPI_TX)
+		napi_schedule(&rtwdev->napi_tx);
+	local_bh_enable();
 }
 
 static irqreturn_t rtw89_pci_interrupt_threadfn(int irq, void *dev)
@@ -758,6 +1252,12 @@ static irqreturn_t rtw89_pci_interrupt_threadfn(int irq, void *dev)
 
 	spin_lock_irqsave(&rtwpci->irq_lock, flags);
 	rtw89_chip_recognize_intrs(rtwdev, rtwpci, &isrs);
+	/* take over events cleared by the hard IRQ handler */
+	isrs.ind_isrs |= rtwpci->thread_isrs.ind_isrs;
+	isrs.halt_c2h_isrs |= rtwpci->thread_isrs.halt_c2h_isrs;
+	isrs.isrs[0] |= rtwpci->thread_isrs.isrs[0];
+	isrs.isrs[1] |= rtwpci->thread_isrs.isrs[1];
+	memset(&rtwpci->thread_isrs, 0, sizeof(rtwpci->thread_isrs));
 	spin_unlock_irqrestore(&rtwpci->irq_lock, flags);
 
 	if (unlikely(isrs.isrs[0] & B_AX_RDU_INT))
@@ -772,16 +1272,8 @@ static irqreturn_t rtw89_pci_interrupt_threadfn(int irq, void *dev)
 	if (unlikely(rtwpci->under_recovery))
 		goto enable_intr;
 
-	if (unlikely(rtwpci->low_power)) {
-		rtw89_pci_low_power_interrupt_handler(rtwdev);
-		goto enable_intr;
-	}
-
-	if (likely(rtwpci->running)) {
-		local_bh_disable();
-		napi_schedule(&rtwdev->napi);
-		local_bh_enable();
-	}
+	if (likely(rtwpci->running))
+		rtw89_pci_napi_schedule(rtwdev, rtwpci, &isrs);
 
 	return IRQ_HANDLED;
 
@@ -797,8 +1289,10 @@ static irqreturn_t rtw89_pci_interrupt_handler(int irq, void *dev)
 {
 	struct rtw89_dev *rtwdev = dev;
 	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	struct rtw89_pci_isrs isrs;
 	unsigned long flags;
 	irqreturn_t irqret = IRQ_WAKE_THREAD;
+	u8 pending;
 
 	spin_lock_irqsave(&rtwpci->irq_lock, flags);
 
@@ -811,6 +1305,33 @@ static irqreturn_t rtw89_pci_interrupt_handler(int irq, void *dev)
 	}
 
 	rtw89_chip_disable_intr(rtwdev, rtwpci);
+	rtwpci->irq_lat.hardirq_ns = ktime_get_ns();
+
+	if (rtw89_pci_disable_irq_fast_path || unlikely(rtwpci->under_recovery))
+		goto exit;
+
+	/* RX and TX release only need NAPI to be scheduled, so do it here
+	 * instead of waking the thread. Events needing process context are
+	 * left to the thread along with the ISRs already read and cleared.
+	 */
+	rtw89_chip_recognize_intrs(rtwdev, rtwpci, &isrs);
+	if (unlikely(isrs.halt_c2h_isrs || isrs.isrs[0] & B_AX_RDU_INT)) {
+		rtwpci->thread_isrs = isrs;
+		goto exit;
+	}
+
+	pending = rtw89_pci_napi_pending(rtwpci, &isrs);
+	rtwpci->napi_pending |= pending;
+	rtw89_pci_irq_lat_mark(rtwpci, pending, RTW89_PCI_IRQ_PATH_HARDIRQ);
+	spin_unlock_irqrestore(&rtwpci->irq_lock, flags);
+
+	if (pending & RTW89_PCI_NAPI_RX)
+		napi_schedule(&rtwdev->napi);
+	if (pending & RTW89_PCI_NAPI_TX)
+		napi_schedule(&rtwdev->napi_tx);
+
+	return IRQ_HANDLED;
+
 exit:
 	spin_unlock_irqrestore(&rtwpci->irq_lock, flags);
 
@@ -921,17 +1442,6 @@ static int rtw89_pci_get_rxch_addrs(struct rtw89_dev *rtwdev,
 	return 0;
 }
 
-static u32 rtw89_pci_get_avail_txbd_num(struct rtw89_pci_tx_ring *ring)
-{
-	struct rtw89_pci_dma_ring *bd_ring = &ring->bd_ring;
-
-	/* reserved 1 desc check ring is full or not */
-	if (bd_ring->rp > bd_ring->wp)
-		return bd_ring->rp - bd_ring->wp - 1;
-
-	return bd_ring->len - (bd_ring->wp - bd_ring->rp) - 1;
-}
-
 static
 u32 __rtw89_pci_check_and_reclaim_tx_fwcmd_resource(struct rtw89_dev *rtwdev)
 {
@@ -939,10 +1449,10 @@ u32 __rtw89_pci_check_and_reclaim_tx_fwcmd_resource(struct rtw89_dev *rtwdev)
 	struct rtw89_pci_tx_ring *tx_ring = &rtwpci->tx_rings[RTW89_TXCH_CH12];
 	u32 cnt;
 
-	spin_lock_bh(&rtwpci->trx_lock);
+	rtw89_pci_tx_ring_lock(tx_ring);
 	rtw89_pci_reclaim_tx_fwcmd(rtwdev, rtwpci);
 	cnt = rtw89_pci_get_avail_txbd_num(tx_ring);
-	spin_unlock_bh(&rtwpci->trx_lock);
+	rtw89_pci_tx_ring_unlock(tx_ring);
 
 	return cnt;
 }
@@ -956,10 +1466,10 @@ u32 __rtw89_pci_check_and_reclaim_tx_resource_noio(struct rtw89_dev *rtwdev,
 	struct rtw89_pci_tx_wd_ring *wd_ring = &tx_ring->wd_ring;
 	u32 cnt;
 
-	spin_lock_bh(&rtwpci->trx_lock);
+	rtw89_pci_tx_ring_lock(tx_ring);
 	cnt = rtw89_pci_get_avail_txbd_num(tx_ring);
 	cnt = min(cnt, wd_ring->curr_num);
-	spin_unlock_bh(&rtwpci->trx_lock);
+	rtw89_pci_tx_ring_unlock(tx_ring);
 
 	return cnt;
 }
@@ -974,21 +1484,33 @@ static u32 __rtw89_pci_check_and_reclaim_tx_resource(struct rtw89_dev *rtwdev,
 	u32 bd_cnt, wd_cnt, min_cnt = 0;
 	struct rtw89_pci_rx_ring *rx_ring;
 	enum rtw89_debug_mask debug_mask;
+	struct sk_buff_head done;
 	u32 cnt;
 
 	rx_ring = &rtwpci->rx_rings[RTW89_RXCH_RPQ];
+	__skb_queue_head_init(&done);
 
-	spin_lock_bh(&rtwpci->trx_lock);
+	rtw89_pci_tx_ring_lock(tx_ring);
 	bd_cnt = rtw89_pci_get_avail_txbd_num(tx_ring);
 	wd_cnt = wd_ring->curr_num;
+	rtw89_pci_tx_ring_unlock(tx_ring);
 
 	if (wd_cnt == 0 || bd_cnt == 0) {
+		/* RPQ releases TX rings with their locks, so don't hold it here */
+		rtw89_pci_rpq_lock(rtwpci);
 		cnt = rtw89_pci_rxbd_recalc(rtwdev, rx_ring);
 		if (cnt)
-			rtw89_pci_release_tx(rtwdev, rx_ring, cnt);
-		else if (wd_cnt == 0)
-			goto out_unlock;
+			rtw89_pci_release_tx(rtwdev, rx_ring, cnt, &done);
+		rtw89_pci_rpq_unlock(rtwpci);
+
+		rtw89_pci_tx_status_report(rtwdev, &done);
+
+		if (!cnt && wd_cnt == 0)
+			return 0;
+	}
 
+	rtw89_pci_tx_ring_lock(tx_ring);
+	if (wd_cnt == 0 || bd_cnt == 0) {
 		bd_cnt = rtw89_pci_get_avail_txbd_num(tx_ring);
 		if (bd_cnt == 0)
 			rtw89_pci_reclaim_txbd(rtwdev, tx_ring);
@@ -996,6 +1518,8 @@ static u32 __rtw89_pci_check_and_reclaim_tx_resource(struct rtw89_dev *rtwdev,
 
 	bd_cnt = rtw89_pci_get_avail_txbd_num(tx_ring);
 	wd_cnt = wd_ring->curr_num;
+	rtw89_pci_tx_ring_unlock(tx_ring);
+
 	min_cnt = min(bd_cnt, wd_cnt);
 	if (min_cnt == 0) {
 		/* This message can be frequently shown in low power mode or
@@ -1012,9 +1536,6 @@ static u32 __rtw89_pci_check_and_reclaim_tx_resource(struct rtw89_dev *rtwdev,
 			    wd_cnt, bd_cnt);
 	}
 
-out_unlock:
-	spin_unlock_bh(&rtwpci->trx_lock);
-
 	return min_cnt;
 }
 
@@ -1032,17 +1553,16 @@ static u32 rtw89_pci_check_and_reclaim_tx_resource(struct rtw89_dev *rtwdev,
 
 static void __rtw89_pci_tx_kick_off(struct rtw89_dev *rtwdev, struct rtw89_pci_tx_ring *tx_ring)
 {
-	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
 	struct rtw89_pci_dma_ring *bd_ring = &tx_ring->bd_ring;
 	u32 host_idx, addr;
 
-	spin_lock_bh(&rtwpci->trx_lock);
+	rtw89_pci_tx_ring_lock(tx_ring);
 
 	addr = bd_ring->addr.idx;
 	host_idx = bd_ring->wp;
-	rtw89_write16(rtwdev, addr, host_idx);
+	rtw89_pci_dp_write16(rtwdev, addr, host_idx);
 
-	spin_unlock_bh(&rtwpci->trx_lock);
+	rtw89_pci_tx_ring_unlock(tx_ring);
 }
 
 static void rtw89_pci_tx_bd_ring_update(struct rtw89_dev *rtwdev, struct rtw89_pci_tx_ring *tx_ring,
@@ -1136,52 +1656,78 @@ static void rtw89_pci_ops_flush_queues(struct rtw89_dev *rtwdev, u32 queues,
 	__rtw89_pci_ops_flush_txchs(rtwdev, BIT(RTW89_TXCH_NUM) - 1, drop);
 }
 
+/* Return length of filled address info, or 0 if segments don't fit */
 u32 rtw89_pci_fill_txaddr_info(struct rtw89_dev *rtwdev,
-			       void *txaddr_info_addr, u32 total_len,
-			       dma_addr_t dma, u8 *add_info_nr)
+			       void *txaddr_info_addr,
+			       const struct rtw89_pci_tx_seg *segs, u8 seg_num,
+			       u8 *add_info_nr)
 {
 	struct rtw89_pci_tx_addr_info_32 *txaddr_info = txaddr_info_addr;
+	u16 option;
+	int n;
+
+	if (seg_num > RTW89_PCI_ADDRINFO_MAX)
+		return 0;
 
-	txaddr_info->length = cpu_to_le16(total_len);
-	txaddr_info->option = cpu_to_le16(RTW89_PCI_ADDR_MSDU_LS |
-					  RTW89_PCI_ADDR_NUM(1));
-	txaddr_info->dma = cpu_to_le32(dma);
+	/* number of entries goes in the first one, LS in the last one */
+	for (n = 0; n < seg_num; n++) {
+		option = n == 0 ? RTW89_PCI_ADDR_NUM(seg_num) : 0;
+		if (n == seg_num - 1)
+			option |= RTW89_PCI_ADDR_MSDU_LS;
 
-	*add_info_nr = 1;
+		txaddr_info->length = cpu_to_le16(segs[n].len);
+		txaddr_info->option = cpu_to_le16(option);
+		txaddr_info->dma = cpu_to_le32(segs[n].dma);
+
+		txaddr_info++;
+	}
 
-	return sizeof(*txaddr_info);
+	*add_info_nr = seg_num;
+
+	return seg_num * sizeof(*txaddr_info);
 }
 EXPORT_SYMBOL(rtw89_pci_fill_txaddr_info);
 
 u32 rtw89_pci_fill_txaddr_info_v1(struct rtw89_dev *rtwdev,
-				  void *txaddr_info_addr, u32 total_len,
-				  dma_addr_t dma, u8 *add_info_nr)
+				  void *txaddr_info_addr,
+				  const struct rtw89_pci_tx_seg *segs, u8 seg_num,
+				  u8 *add_info_nr)
 {
 	struct rtw89_pci_tx_addr_info_32_v1 *txaddr_info = txaddr_info_addr;
-	u32 remain = total_len;
+	dma_addr_t dma;
+	u32 remain;
 	u32 len;
 	u16 length_option;
-	int n;
-
-	for (n = 0; n < RTW89_TXADDR_INFO_NR_V1 && remain; n++) {
-		len = remain >= TXADDR_INFO_LENTHG_V1_MAX ?
-		      TXADDR_INFO_LENTHG_V1_MAX : remain;
-		remain -= len;
-
-		length_option = FIELD_PREP(B_PCIADDR_LEN_V1_MASK, len) |
-				FIELD_PREP(B_PCIADDR_HIGH_SEL_V1_MASK, 0) |
-				FIELD_PREP(B_PCIADDR_LS_V1_MASK, remain == 0);
-		txaddr_info->length_opt = cpu_to_le16(length_option);
-		txaddr_info->dma_low_lsb = cpu_to_le16(FIELD_GET(GENMASK(15, 0), dma));
-		txaddr_info->dma_low_msb = cpu_to_le16(FIELD_GET(GENMASK(31, 16), dma));
+	bool last;
+	int n = 0;
+	int i;
 
-		dma += len;
-		txaddr_info++;
+	for (i = 0; i < seg_num; i++) {
+		dma = segs[i].dma;
+		remain = segs[i].len;
+
+		while (remain) {
+			if (n >= RTW89_TXADDR_INFO_NR_V1)
+				return 0;
+
+			len = remain >= TXADDR_INFO_LENTHG_V1_MAX ?
+			      TXADDR_INFO_LENTHG_V1_MAX : remain;
+			remain -= len;
+			last = i == seg_num - 1 && remain == 0;
+
+			length_option = FIELD_PREP(B_PCIADDR_LEN_V1_MASK, len) |
+					FIELD_PREP(B_PCIADDR_HIGH_SEL_V1_MASK, 0) |
+					FIELD_PREP(B_PCIADDR_LS_V1_MASK, last);
+			txaddr_info->length_opt = cpu_to_le16(length_option);
+			txaddr_info->dma_low_lsb = cpu_to_le16(FIELD_GET(GENMASK(15, 0), dma));
+			txaddr_info->dma_low_msb = cpu_to_le16(FIELD_GET(GENMASK(31, 16), dma));
+
+			dma += len;
+			txaddr_info++;
+			n++;
+		}
 	}
 
-	WARN_ONCE(remain, "length overflow remain=%u total_len=%u",
-		  remain, total_len);
-
 	*add_info_nr = n;
 
 	return n * sizeof(*txaddr_info);
@@ -1193,36 +1739,91 @@ static int rtw89_pci_txwd_submit(struct rtw89_dev *rtwdev,
 				 struct rtw89_pci_tx_wd *txwd,
 				 struct rtw89_core_tx_request *tx_req)
 {
-	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	const struct rtw89_pci_info *info = rtwdev->pci_info;
 	const struct rtw89_chip_info *chip = rtwdev->chip;
 	struct rtw89_tx_desc_info *desc_info = &tx_req->desc_info;
 	struct rtw89_txwd_info *txwd_info;
 	struct rtw89_pci_tx_wp_info *txwp_info;
 	void *txaddr_info_addr;
-	struct pci_dev *pdev = rtwpci->pdev;
 	struct sk_buff *skb = tx_req->skb;
 	struct rtw89_pci_tx_data *tx_data = RTW89_PCI_TX_SKB_CB(skb);
 	struct rtw89_tx_skb_data *skb_data = RTW89_TX_SKB_CB(skb);
+	struct rtw89_pci_tx_seg segs[RTW89_PCI_TX_SEG_MAX];
 	bool en_wd_info = desc_info->en_wd_info;
 	u32 txwd_len;
 	u32 txwp_len;
 	u32 txaddr_info_len;
-	dma_addr_t dma;
+	u8 frag_max = 0;
+	u8 seg_num = 1;
 	int ret;
 
-	dma = dma_map_single(&pdev->dev, skb->data, skb->len, DMA_TO_DEVICE);
-	if (dma_mapping_error(&pdev->dev, dma)) {
-		rtw89_err(rtwdev, "failed to map skb dma data\n");
-		ret = -EBUSY;
-		goto err;
-	}
-
-	tx_data->dma = dma;
-	rcu_assign_pointer(skb_data->wait, NULL);
-
 	txwp_len = sizeof(*txwp_info);
 	txwd_len = chip->txwd_body_size;
 	txwd_len += en_wd_info ? sizeof(*txwd_info) : 0;
+	txaddr_info_addr = txwd->vaddr + txwd_len + txwp_len;
+
+	/* one address info entry is taken by linear data */
+	if (tx_ring->wd_ring.frag_dma)
+		frag_max = min_t(u8, info->txaddr_info_nr_max - 1,
+				 RTW89_PCI_TX_FRAG_MAX);
+
+	if (skb_shinfo(skb)->nr_frags > frag_max) {
+		ret = skb_linearize(skb);
+		if (ret)
+			goto err;
+		tx_ring->tx_linearized++;
+	}
+
+retry:
+	if (skb->len <= tx_ring->wd_ring.copybreak) {
+		/* copybreak buffer is coherent, so no sync is needed */
+		ret = skb_copy_bits(skb, 0, txwd->vaddr + RTW89_PCI_TXWD_PAGE_SIZE,
+				    skb->len);
+		if (ret)
+			goto err;
+
+		segs[0].dma = txwd->paddr + RTW89_PCI_TXWD_PAGE_SIZE;
+		segs[0].len = skb->len;
+		txwd->copied = true;
+	} else {
+		ret = rtw89_pci_tx_map_skb(rtwdev, &tx_ring->wd_ring, txwd, skb,
+					   segs, &seg_num);
+		if (ret) {
+			rtw89_err(rtwdev, "failed to map skb dma data\n");
+			goto err;
+		}
+	}
+
+	txaddr_info_len =
+		rtw89_chip_fill_txaddr_info(rtwdev, txaddr_info_addr, segs,
+					    seg_num, &desc_info->addr_info_nr);
+	if (!txaddr_info_len) {
+		/* too many address info entries; fall back to linear data */
+		if (WARN_ON_ONCE(txwd->copied || !skb_is_nonlinear(skb))) {
+			ret = -EINVAL;
+			goto err_release;
+		}
+
+		rtw89_pci_tx_unmap_skb(rtwdev, &tx_ring->wd_ring, txwd, skb,
+				       segs[0].dma);
+		ret = skb_linearize(skb);
+		if (ret)
+			goto err;
+
+		tx_ring->tx_linearized++;
+		seg_num = 1;
+		goto retry;
+	}
+
+	if (txwd->copied)
+		tx_ring->tx_copied++;
+	else
+		tx_ring->tx_mapped++;
+	if (seg_num > 1)
+		tx_ring->tx_sg++;
+
+	tx_data->dma = segs[0].dma;
+	rcu_assign_pointer(skb_data->wait, NULL);
 
 	txwp_info = txwd->vaddr + txwd_len;
 	txwp_info->seq0 = cpu_to_le16(txwd->seq | RTW89_PCI_TXWP_VALID);
@@ -1231,11 +1832,6 @@ static int rtw89_pci_txwd_submit(struct rtw89_dev *rtwdev,
 	txwp_info->seq3 = 0;
 
 	tx_ring->tx_cnt++;
-	txaddr_info_addr = txwd->vaddr + txwd_len + txwp_len;
-	txaddr_info_len =
-		rtw89_chip_fill_txaddr_info(rtwdev, txaddr_info_addr, skb->len,
-					    dma, &desc_info->addr_info_nr);
-
 	txwd->len = txwd_len + txwp_len + txaddr_info_len;
 
 	rtw89_chip_fill_txdesc(rtwdev, desc_info, txwd->vaddr);
@@ -1244,6 +1840,12 @@ static int rtw89_pci_txwd_submit(struct rtw89_dev *rtwdev,
 
 	return 0;
 
+err_release:
+	if (txwd->copied)
+		txwd->copied = false;
+	else
+		rtw89_pci_tx_unmap_skb(rtwdev, &tx_ring->wd_ring, txwd, skb,
+				       segs[0].dma);
 err:
 	return ret;
 }
@@ -1347,7 +1949,7 @@ static int rtw89_pci_tx_write(struct rtw89_dev *rtwdev, struct rtw89_core_tx_req
 	}
 
 	tx_ring = &rtwpci->tx_rings[txch];
-	spin_lock_bh(&rtwpci->trx_lock);
+	rtw89_pci_tx_ring_lock(tx_ring);
 
 	n_avail_txbd = rtw89_pci_get_avail_txbd_num(tx_ring);
 	if (n_avail_txbd == 0) {
@@ -1363,11 +1965,15 @@ static int rtw89_pci_tx_write(struct rtw89_dev *rtwdev, struct rtw89_core_tx_req
 		goto err_unlock;
 	}
 
-	spin_unlock_bh(&rtwpci->trx_lock);
+	if (txch != RTW89_TXCH_CH12)
+		tx_ring->wd_hwm = max(tx_ring->wd_hwm, tx_ring->wd_ring.page_num -
+						       tx_ring->wd_ring.curr_num);
+
+	rtw89_pci_tx_ring_unlock(tx_ring);
 	return 0;
 
 err_unlock:
-	spin_unlock_bh(&rtwpci->trx_lock);
+	rtw89_pci_tx_ring_unlock(tx_ring);
 	return ret;
 }
 
@@ -1466,32 +2072,148 @@ static void rtw89_pci_reset_trx_rings(struct rtw89_dev *rtwdev)
 }
 
 static void rtw89_pci_release_tx_ring(struct rtw89_dev *rtwdev,
-				      struct rtw89_pci_tx_ring *tx_ring)
+				      struct rtw89_pci_tx_ring *tx_ring,
+				      struct sk_buff_head *done)
 {
 	rtw89_pci_release_busy_txwd(rtwdev, tx_ring);
-	rtw89_pci_release_pending_txwd_skb(rtwdev, tx_ring);
+	rtw89_pci_release_pending_txwd_skb(rtwdev, tx_ring, done);
+}
+
+static void rtw89_pci_ops_reset(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	const struct rtw89_pci_info *info = rtwdev->pci_info;
+	struct rtw89_pci_tx_ring *tx_ring;
+	struct sk_buff_head done;
+	int txch;
+
+	if (!rtwpci->rings_allocated)
+		return;
+
+	__skb_queue_head_init(&done);
+	rtw89_pci_reset_trx_rings(rtwdev);
+
+	for (txch = 0; txch < RTW89_TXCH_NUM; txch++) {
+		if (info->tx_dma_ch_mask & BIT(txch))
+			continue;
+
+		tx_ring = &rtwpci->tx_rings[txch];
+		rtw89_pci_tx_ring_lock(tx_ring);
+		if (txch == RTW89_TXCH_CH12)
+			rtw89_pci_release_fwcmd(rtwdev, rtwpci,
+						skb_queue_len(&rtwpci->h2c_queue), true);
+		else
+			rtw89_pci_release_tx_ring(rtwdev, tx_ring, &done);
+		rtw89_pci_tx_ring_unlock(tx_ring);
+	}
+
+	rtw89_pci_tx_status_report(rtwdev, &done);
+}
+
+struct rtw89_pci_dim_profile {
+	u8 counter;
+	u16 timer_us;
+};
+
+/* indexed by profile_ix picked by net_dim() */
+static const struct rtw89_pci_dim_profile
+rtw89_pci_dim_profiles[RTW89_PCI_DIM_PROFILE_NUM] = {
+	{0, 0},
+	{4, 64},
+	{16, 256},
+	{32, 1024},
+	{RTW89_PCI_RXBD_NUM_DEF / 2, 2048},
+};
+
+static u32 rtw89_pci_int_mit_rx_val(u32 counter, u16 timer_us)
+{
+	if (!counter && !timer_us)
+		return 0;
+
+	/* half of a deep RX ring can exceed the counter field */
+	counter = min_t(u32, counter, FIELD_MAX(B_AX_RXCOUNTER_MATCH_MASK));
+
+	return B_AX_RXMIT_RXP2_SEL | B_AX_RXMIT_RXP1_SEL |
+	       FIELD_PREP(B_AX_RXCOUNTER_MATCH_MASK, counter) |
+	       FIELD_PREP(B_AX_RXTIMER_UNIT_MASK, AX_RXTIMER_UNIT_64US) |
+	       FIELD_PREP(B_AX_RXTIMER_MATCH_MASK, timer_us / 64);
+}
+
+static void rtw89_pci_dim_apply(struct rtw89_dev *rtwdev,
+				struct rtw89_pci *rtwpci, u8 profile_ix)
+{
+	const struct rtw89_pci_dim_profile *profile;
+	struct rtw89_pci_dim *dim = &rtwpci->dim;
+	unsigned long flags;
+
+	profile = &rtw89_pci_dim_profiles[profile_ix];
+
+	/* scanning sets no moderation, and it's restored after scanning */
+	spin_lock_irqsave(&rtwpci->irq_lock, flags);
+	if (likely(rtwpci->running) && !rtwdev->scanning &&
+	    dim->hw_profile_ix != profile_ix) {
+		dim->hw_profile_ix = profile_ix;
+		dim->hw_val = rtw89_pci_int_mit_rx_val(min_t(u32, profile->counter,
+							     rtwpci->rxbd_num / 2),
+						       profile->timer_us);
+		rtw89_write32(rtwdev, R_AX_INT_MIT_RX, dim->hw_val);
+		dim->transitions++;
+	}
+	spin_unlock_irqrestore(&rtwpci->irq_lock, flags);
+}
+
+static void rtw89_pci_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct rtw89_dev *rtwdev = dim->priv;
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+
+	rtw89_pci_dim_apply(rtwdev, rtwpci, dim->profile_ix);
+	dim->state = DIM_START_MEASURE;
+}
+
+static void rtw89_pci_dim_reset(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	struct rtw89_pci_dim *dim = &rtwpci->dim;
+	unsigned long flags;
+
+	if (rtw89_pci_disable_dim)
+		return;
+
+	memset(&dim->dim, 0, sizeof(dim->dim));
+	INIT_WORK(&dim->dim.work, rtw89_pci_dim_work);
+	dim->dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+	dim->dim.priv = rtwdev;
+	dim->events = 0;
+
+	spin_lock_irqsave(&rtwpci->irq_lock, flags);
+	dim->hw_profile_ix = 0;
+	dim->hw_val = 0;
+	rtw89_write32(rtwdev, R_AX_INT_MIT_RX, 0);
+	spin_unlock_irqrestore(&rtwpci->irq_lock, flags);
 }
 
-static void rtw89_pci_ops_reset(struct rtw89_dev *rtwdev)
+static void rtw89_pci_dim_update(struct rtw89_dev *rtwdev,
+				 struct rtw89_pci *rtwpci)
 {
-	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
-	const struct rtw89_pci_info *info = rtwdev->pci_info;
-	int txch;
+	struct rtw89_pci_rx_ring *rx_ring = &rtwpci->rx_rings[RTW89_RXCH_RXQ];
+	struct rtw89_pci_dim *dim = &rtwpci->dim;
+	struct dim_sample sample = {};
 
-	rtw89_pci_reset_trx_rings(rtwdev);
+	if (rtw89_pci_disable_dim)
+		return;
 
-	spin_lock_bh(&rtwpci->trx_lock);
-	for (txch = 0; txch < RTW89_TXCH_NUM; txch++) {
-		if (info->tx_dma_ch_mask & BIT(txch))
-			continue;
-		if (txch == RTW89_TXCH_CH12) {
-			rtw89_pci_release_fwcmd(rtwdev, rtwpci,
-						skb_queue_len(&rtwpci->h2c_queue), true);
-			continue;
-		}
-		rtw89_pci_release_tx_ring(rtwdev, &rtwpci->tx_rings[txch]);
-	}
-	spin_unlock_bh(&rtwpci->trx_lock);
+	dim->events++;
+	dim->profile_polls[dim->dim.profile_ix]++;
+	dim_update_sample(dim->events,
+			  rx_ring->rx_copied + rx_ring->rx_zero_copy,
+			  rx_ring->rx_bytes, &sample);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+	net_dim(&dim->dim, &sample);
+#else
+	net_dim(&dim->dim, sample);
+#endif
 }
 
 static void rtw89_pci_enable_intr_lock(struct rtw89_dev *rtwdev)
@@ -1501,6 +2223,8 @@ static void rtw89_pci_enable_intr_lock(struct rtw89_dev *rtwdev)
 
 	spin_lock_irqsave(&rtwpci->irq_lock, flags);
 	rtwpci->running = true;
+	rtwpci->napi_pending = 0;
+	memset(&rtwpci->thread_isrs, 0, sizeof(rtwpci->thread_isrs));
 	rtw89_chip_enable_intr(rtwdev, rtwpci);
 	spin_unlock_irqrestore(&rtwpci->irq_lock, flags);
 }
@@ -1518,6 +2242,7 @@ static void rtw89_pci_disable_intr_lock(struct rtw89_dev *rtwdev)
 
 static int rtw89_pci_ops_start(struct rtw89_dev *rtwdev)
 {
+	rtw89_pci_dim_reset(rtwdev);
 	rtw89_core_napi_start(rtwdev);
 	rtw89_pci_enable_intr_lock(rtwdev);
 
@@ -1532,6 +2257,8 @@ static void rtw89_pci_ops_stop(struct rtw89_dev *rtwdev)
 	rtw89_pci_disable_intr_lock(rtwdev);
 	synchronize_irq(pdev->irq);
 	rtw89_core_napi_stop(rtwdev);
+	if (!rtw89_pci_disable_dim)
+		cancel_work_sync(&rtwpci->dim.dim.work);
 }
 
 static void rtw89_pci_ops_pause(struct rtw89_dev *rtwdev, bool pause)
@@ -1542,8 +2269,10 @@ static void rtw89_pci_ops_pause(struct rtw89_dev *rtwdev, bool pause)
 	if (pause) {
 		rtw89_pci_disable_intr_lock(rtwdev);
 		synchronize_irq(pdev->irq);
-		if (test_bit(RTW89_FLAG_NAPI_RUNNING, rtwdev->flags))
+		if (test_bit(RTW89_FLAG_NAPI_RUNNING, rtwdev->flags)) {
 			napi_synchronize(&rtwdev->napi);
+			napi_synchronize(&rtwdev->napi_tx);
+		}
 	} else {
 		rtw89_pci_enable_intr_lock(rtwdev);
 		rtw89_pci_tx_kick_off_pending(rtwdev);
@@ -2477,10 +3206,13 @@ static int rtw89_pci_mode_op(struct rtw89_dev *rtwdev)
 	return 0;
 }
 
+static void rtw89_pci_link_pm_reset(struct rtw89_dev *rtwdev);
+
 static int rtw89_pci_ops_deinit(struct rtw89_dev *rtwdev)
 {
 	const struct rtw89_pci_info *info = rtwdev->pci_info;
 
+	rtw89_pci_link_pm_reset(rtwdev);
 	if (rtwdev->chip->chip_id == RTL8852A) {
 		/* ltr sw trigger */
 		rtw89_write32_set(rtwdev, R_AX_LTR_CTRL_0, B_AX_APP_LTR_IDLE);
@@ -2494,9 +3226,15 @@ static int rtw89_pci_ops_deinit(struct rtw89_dev *rtwdev)
 
 static int rtw89_pci_ops_mac_pre_init(struct rtw89_dev *rtwdev)
 {
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
 	const struct rtw89_pci_info *info = rtwdev->pci_info;
 	int ret;
 
+	if (!rtwpci->rings_allocated) {
+		rtw89_err(rtwdev, "[ERR] no DMA rings, resize them again\n");
+		return -ENOMEM;
+	}
+
 	rtw89_pci_rxdma_prefth(rtwdev);
 	rtw89_pci_l1off_pwroff(rtwdev);
 	rtw89_pci_deglitch_setting(rtwdev);
@@ -2595,8 +3333,10 @@ int rtw89_pci_ltr_set(struct rtw89_dev *rtwdev, bool en)
 			   PCI_LTR_IDLE_TIMER_3_2MS);
 	rtw89_write32_mask(rtwdev, R_AX_LTR_CTRL_1, B_AX_LTR_RX0_TH_MASK, 0x28);
 	rtw89_write32_mask(rtwdev, R_AX_LTR_CTRL_1, B_AX_LTR_RX1_TH_MASK, 0x28);
-	rtw89_write32(rtwdev, R_AX_LTR_IDLE_LATENCY, 0x90039003);
-	rtw89_write32(rtwdev, R_AX_LTR_ACTIVE_LATENCY, 0x880b880b);
+	rtw89_write32(rtwdev, R_AX_LTR_IDLE_LATENCY,
+		      RTW89_PCI_LTR_IDLE_LATENCY);
+	rtw89_write32(rtwdev, R_AX_LTR_ACTIVE_LATENCY,
+		      RTW89_PCI_LTR_ACTIVE_LATENCY);
 
 	return 0;
 }
@@ -2642,8 +3382,10 @@ int rtw89_pci_ltr_set_v1(struct rtw89_dev *rtwdev, bool en)
 	rtw89_write32_mask(rtwdev, R_AX_LTR_CTRL_1, B_AX_LTR_RX0_TH_MASK, 0x28);
 	rtw89_write32_mask(rtwdev, R_AX_LTR_CTRL_1, B_AX_LTR_RX1_TH_MASK, 0x28);
 	rtw89_write32(rtwdev, R_AX_LTR_DEC_CTRL, dec_ctrl);
-	rtw89_write32(rtwdev, R_AX_LTR_LATENCY_IDX3, 0x90039003);
-	rtw89_write32(rtwdev, R_AX_LTR_LATENCY_IDX0, 0x880b880b);
+	rtw89_write32(rtwdev, R_AX_LTR_LATENCY_IDX3,
+		      RTW89_PCI_LTR_IDLE_LATENCY);
+	rtw89_write32(rtwdev, R_AX_LTR_LATENCY_IDX0,
+		      RTW89_PCI_LTR_ACTIVE_LATENCY);
 
 	return 0;
 }
@@ -2651,6 +3393,7 @@ EXPORT_SYMBOL(rtw89_pci_ltr_set_v1);
 
 static int rtw89_pci_ops_mac_post_init(struct rtw89_dev *rtwdev)
 {
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
 	const struct rtw89_pci_info *info = rtwdev->pci_info;
 	enum rtw89_core_chip_id chip_id = rtwdev->chip->chip_id;
 	int ret;
@@ -2660,6 +3403,7 @@ static int rtw89_pci_ops_mac_post_init(struct rtw89_dev *rtwdev)
 		rtw89_err(rtwdev, "pci ltr set fail\n");
 		return ret;
 	}
+	rtwpci->link_pm.ltr = true;
 	if (chip_id == RTL8852A) {
 		/* ltr sw trigger */
 		rtw89_write32_set(rtwdev, R_AX_LTR_CTRL_0, B_AX_APP_LTR_ACT);
@@ -2760,10 +3504,142 @@ static void rtw89_pci_clear_mapping(struct rtw89_dev *rtwdev,
 	}
 }
 
+static u32 rtw89_pci_txwd_copybreak(void)
+{
+	return min_t(u32, rtw89_pci_tx_copybreak, RTW89_PCI_TX_COPYBREAK_MAX);
+}
+
+static u32 rtw89_pci_txwd_page_size(void)
+{
+	u32 page_size = RTW89_PCI_TXWD_PAGE_SIZE;
+
+	if (rtw89_pci_txwd_copybreak())
+		page_size += RTW89_PCI_TX_COPYBREAK_MAX;
+
+	return page_size;
+}
+
+/* DMA arenas layout, each ring starts at RTW89_PCI_DMA_ARENA_ALIGN:
+ *
+ *   BD arena: | TXBD CH0 | ... | TXBD CH12 | RXBD RXQ | RXBD RPQ |
+ *   WD arena: | TXWD CH0 | ... | TXWD CH11 |
+ *
+ * Channels masked by tx_dma_ch_mask are skipped, and CH12 has no TXWD.
+ * If an arena can't be allocated, its rings fall back to be allocated
+ * separately.
+ */
+static u32 rtw89_pci_dma_arena_size(struct rtw89_dev *rtwdev, bool wd)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	const struct rtw89_pci_info *info = rtwdev->pci_info;
+	u32 size = 0;
+	int i;
+
+	for (i = 0; i < RTW89_TXCH_NUM; i++) {
+		if (info->tx_dma_ch_mask & BIT(i))
+			continue;
+
+		if (!wd)
+			size += ALIGN(rtwpci->txbd_num * sizeof(struct rtw89_pci_tx_bd_32),
+				      RTW89_PCI_DMA_ARENA_ALIGN);
+		else if (i != RTW89_TXCH_CH12)
+			size += ALIGN(rtwpci->txwd_num * rtw89_pci_txwd_page_size(),
+				      RTW89_PCI_DMA_ARENA_ALIGN);
+	}
+
+	if (!wd)
+		size += RTW89_RXCH_NUM *
+			ALIGN(rtwpci->rxbd_num * sizeof(struct rtw89_pci_rx_bd_32),
+			      RTW89_PCI_DMA_ARENA_ALIGN);
+
+	return size;
+}
+
+static void rtw89_pci_alloc_dma_arena(struct rtw89_dev *rtwdev,
+				      struct pci_dev *pdev,
+				      struct rtw89_pci_dma_arena *arena, bool wd)
+{
+	arena->offset = 0;
+	arena->size = rtw89_pci_dma_arena_size(rtwdev, wd);
+	arena->head = dma_alloc_coherent(&pdev->dev, arena->size, &arena->dma,
+					 GFP_KERNEL | __GFP_NOWARN);
+	if (!arena->head) {
+		rtw89_debug(rtwdev, RTW89_DBG_UNEXP,
+			    "failed to alloc %s arena of %u bytes, fall back to separate rings\n",
+			    wd ? "WD" : "BD", arena->size);
+		arena->size = 0;
+	}
+}
+
+static void rtw89_pci_free_dma_arena(struct pci_dev *pdev,
+				     struct rtw89_pci_dma_arena *arena)
+{
+	if (!arena->head)
+		return;
+
+	dma_free_coherent(&pdev->dev, arena->size, arena->head, arena->dma);
+	arena->head = NULL;
+	arena->size = 0;
+	arena->offset = 0;
+}
+
+static void rtw89_pci_alloc_dma_arenas(struct rtw89_dev *rtwdev,
+				       struct pci_dev *pdev)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+
+	if (rtw89_pci_disable_dma_arena)
+		return;
+
+	rtw89_pci_alloc_dma_arena(rtwdev, pdev, &rtwpci->bd_arena, false);
+	rtw89_pci_alloc_dma_arena(rtwdev, pdev, &rtwpci->wd_arena, true);
+}
+
+static void rtw89_pci_free_dma_arenas(struct rtw89_dev *rtwdev,
+				      struct pci_dev *pdev)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+
+	rtw89_pci_free_dma_arena(pdev, &rtwpci->bd_arena);
+	rtw89_pci_free_dma_arena(pdev, &rtwpci->wd_arena);
+}
+
+static void *rtw89_pci_dma_alloc(struct pci_dev *pdev,
+				 struct rtw89_pci_dma_arena *arena,
+				 u32 size, dma_addr_t *dma)
+{
+	u32 offset;
+
+	if (!arena->head)
+		return dma_alloc_coherent(&pdev->dev, size, dma, GFP_KERNEL);
+
+	offset = ALIGN(arena->offset, RTW89_PCI_DMA_ARENA_ALIGN);
+	if (WARN_ON(offset + size > arena->size))
+		return NULL;
+
+	arena->offset = offset + size;
+	*dma = arena->dma + offset;
+	memset(arena->head + offset, 0, size);
+
+	return arena->head + offset;
+}
+
+static void rtw89_pci_dma_free(struct pci_dev *pdev,
+			       struct rtw89_pci_dma_arena *arena,
+			       u32 size, void *head, dma_addr_t dma)
+{
+	/* carved rings are released along with the arena */
+	if (arena->head)
+		return;
+
+	dma_free_coherent(&pdev->dev, size, head, dma);
+}
+
 static void rtw89_pci_free_tx_wd_ring(struct rtw89_dev *rtwdev,
 				      struct pci_dev *pdev,
 				      struct rtw89_pci_tx_ring *tx_ring)
 {
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
 	struct rtw89_pci_tx_wd_ring *wd_ring = &tx_ring->wd_ring;
 	u8 *head = wd_ring->head;
 	dma_addr_t dma = wd_ring->dma;
@@ -2771,14 +3647,20 @@ static void rtw89_pci_free_tx_wd_ring(struct rtw89_dev *rtwdev,
 	u32 page_num = wd_ring->page_num;
 	u32 ring_sz = page_size * page_num;
 
-	dma_free_coherent(&pdev->dev, ring_sz, head, dma);
+	rtw89_pci_dma_free(pdev, &rtwpci->wd_arena, ring_sz, head, dma);
 	wd_ring->head = NULL;
+
+	kvfree(wd_ring->frag_dma);
+	wd_ring->frag_dma = NULL;
+	kvfree(wd_ring->pages);
+	wd_ring->pages = NULL;
 }
 
 static void rtw89_pci_free_tx_ring(struct rtw89_dev *rtwdev,
 				   struct pci_dev *pdev,
 				   struct rtw89_pci_tx_ring *tx_ring)
 {
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
 	int ring_sz;
 	u8 *head;
 	dma_addr_t dma;
@@ -2786,7 +3668,7 @@ static void rtw89_pci_free_tx_ring(struct rtw89_dev *rtwdev,
 	head = tx_ring->bd_ring.head;
 	dma = tx_ring->bd_ring.dma;
 	ring_sz = tx_ring->bd_ring.desc_size * tx_ring->bd_ring.len;
-	dma_free_coherent(&pdev->dev, ring_sz, head, dma);
+	rtw89_pci_dma_free(pdev, &rtwpci->bd_arena, ring_sz, head, dma);
 
 	tx_ring->bd_ring.head = NULL;
 }
@@ -2808,10 +3690,81 @@ static void rtw89_pci_free_tx_rings(struct rtw89_dev *rtwdev,
 	}
 }
 
+#ifdef RTW89_PCI_RX_ZERO_COPY
+static void rtw89_pci_free_rx_pages(struct rtw89_dev *rtwdev,
+				    struct rtw89_pci_rx_ring *rx_ring)
+{
+	struct rtw89_pci_rx_page *rx_page;
+	int i;
+
+	for (i = 0; i < rx_ring->bd_ring.len; i++) {
+		rx_page = &rx_ring->pages[i];
+		if (!rx_page->page)
+			continue;
+
+		page_pool_put_full_page(rx_ring->page_pool, rx_page->page, false);
+		rx_page->page = NULL;
+	}
+
+	page_pool_destroy(rx_ring->page_pool);
+	rx_ring->page_pool = NULL;
+}
+
+static int rtw89_pci_alloc_rx_pages(struct rtw89_dev *rtwdev,
+				    struct pci_dev *pdev,
+				    struct rtw89_pci_rx_ring *rx_ring, u32 len)
+{
+	struct page_pool_params pp_params = {
+		.order = RTW89_PCI_RX_PP_ORDER,
+		.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV,
+		.pool_size = len,
+		.nid = dev_to_node(&pdev->dev),
+		.dev = &pdev->dev,
+		.dma_dir = DMA_FROM_DEVICE,
+		.offset = RTW89_PCI_RX_PP_HEADROOM,
+		.max_len = RTW89_PCI_RX_BUF_SIZE,
+	};
+	struct page_pool *page_pool;
+	struct page *page;
+	u32 i;
+
+	page_pool = page_pool_create(&pp_params);
+	if (IS_ERR(page_pool))
+		return PTR_ERR(page_pool);
+
+	rx_ring->page_pool = page_pool;
+
+	for (i = 0; i < len; i++) {
+		page = page_pool_dev_alloc_pages(page_pool);
+		if (!page) {
+			rtw89_pci_free_rx_pages(rtwdev, rx_ring);
+			return -ENOMEM;
+		}
+
+		rtw89_pci_init_rx_bd_page(rx_ring, page, i);
+	}
+
+	return 0;
+}
+#else
+static void rtw89_pci_free_rx_pages(struct rtw89_dev *rtwdev,
+				    struct rtw89_pci_rx_ring *rx_ring)
+{
+}
+
+static int rtw89_pci_alloc_rx_pages(struct rtw89_dev *rtwdev,
+				    struct pci_dev *pdev,
+				    struct rtw89_pci_rx_ring *rx_ring, u32 len)
+{
+	return -EOPNOTSUPP;
+}
+#endif
+
 static void rtw89_pci_free_rx_ring(struct rtw89_dev *rtwdev,
 				   struct pci_dev *pdev,
 				   struct rtw89_pci_rx_ring *rx_ring)
 {
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
 	struct rtw89_pci_rx_info *rx_info;
 	struct sk_buff *skb;
 	dma_addr_t dma;
@@ -2820,6 +3773,11 @@ static void rtw89_pci_free_rx_ring(struct rtw89_dev *rtwdev,
 	int ring_sz = rx_ring->bd_ring.desc_size * rx_ring->bd_ring.len;
 	int i;
 
+	if (rx_ring->page_pool) {
+		rtw89_pci_free_rx_pages(rtwdev, rx_ring);
+		goto free_bd;
+	}
+
 	buf_sz = rx_ring->buf_sz;
 	for (i = 0; i < rx_ring->bd_ring.len; i++) {
 		skb = rx_ring->buf[i];
@@ -2833,11 +3791,17 @@ static void rtw89_pci_free_rx_ring(struct rtw89_dev *rtwdev,
 		rx_ring->buf[i] = NULL;
 	}
 
+free_bd:
 	head = rx_ring->bd_ring.head;
 	dma = rx_ring->bd_ring.dma;
-	dma_free_coherent(&pdev->dev, ring_sz, head, dma);
+	rtw89_pci_dma_free(pdev, &rtwpci->bd_arena, ring_sz, head, dma);
 
 	rx_ring->bd_ring.head = NULL;
+
+	kvfree(rx_ring->buf);
+	rx_ring->buf = NULL;
+	kvfree(rx_ring->pages);
+	rx_ring->pages = NULL;
 }
 
 static void rtw89_pci_free_rx_rings(struct rtw89_dev *rtwdev,
@@ -2856,8 +3820,15 @@ static void rtw89_pci_free_rx_rings(struct rtw89_dev *rtwdev,
 static void rtw89_pci_free_trx_rings(struct rtw89_dev *rtwdev,
 				     struct pci_dev *pdev)
 {
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+
+	if (!rtwpci->rings_allocated)
+		return;
+
 	rtw89_pci_free_rx_rings(rtwdev, pdev);
 	rtw89_pci_free_tx_rings(rtwdev, pdev);
+	rtw89_pci_free_dma_arenas(rtwdev, pdev);
+	rtwpci->rings_allocated = false;
 }
 
 static int rtw89_pci_init_rx_bd(struct rtw89_dev *rtwdev, struct pci_dev *pdev,
@@ -2897,9 +3868,11 @@ static int rtw89_pci_alloc_tx_wd_ring(struct rtw89_dev *rtwdev,
 	dma_addr_t cur_paddr;
 	u8 *head;
 	u8 *cur_vaddr;
-	u32 page_size = RTW89_PCI_TXWD_PAGE_SIZE;
-	u32 page_num = RTW89_PCI_TXWD_NUM_MAX;
-	u32 ring_sz = page_size * page_num;
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	u32 page_size = rtw89_pci_txwd_page_size();
+	u32 page_num = rtwpci->txwd_num;
+	u32 copybreak;
+	u32 ring_sz;
 	u32 page_offset;
 	int i;
 
@@ -2907,15 +3880,31 @@ static int rtw89_pci_alloc_tx_wd_ring(struct rtw89_dev *rtwdev,
 	if (txch == RTW89_TXCH_CH12)
 		return 0;
 
-	head = dma_alloc_coherent(&pdev->dev, ring_sz, &dma, GFP_KERNEL);
+	copybreak = rtw89_pci_txwd_copybreak();
+	ring_sz = page_size * page_num;
+
+	head = rtw89_pci_dma_alloc(pdev, &rtwpci->wd_arena, ring_sz, &dma);
 	if (!head)
 		return -ENOMEM;
 
+	wd_ring->pages = kvcalloc(page_num, sizeof(*wd_ring->pages), GFP_KERNEL);
+	if (!wd_ring->pages)
+		goto err_free_head;
+
+	if (!rtw89_pci_disable_tx_sg) {
+		wd_ring->frag_dma = kvcalloc(page_num * RTW89_PCI_TX_FRAG_MAX,
+					     sizeof(*wd_ring->frag_dma),
+					     GFP_KERNEL);
+		if (!wd_ring->frag_dma)
+			goto err_free_pages;
+	}
+
 	INIT_LIST_HEAD(&wd_ring->free_pages);
 	wd_ring->head = head;
 	wd_ring->dma = dma;
 	wd_ring->page_size = page_size;
 	wd_ring->page_num = page_num;
+	wd_ring->copybreak = copybreak;
 
 	page_offset = 0;
 	for (i = 0; i < page_num; i++) {
@@ -2929,12 +3918,21 @@ static int rtw89_pci_alloc_tx_wd_ring(struct rtw89_dev *rtwdev,
 		txwd->vaddr = cur_vaddr;
 		txwd->len = page_size;
 		txwd->seq = i;
+		txwd->copied = false;
+		txwd->nr_frags = 0;
 		rtw89_pci_enqueue_txwd(tx_ring, txwd);
 
 		page_offset += page_size;
 	}
 
 	return 0;
+
+err_free_pages:
+	kvfree(wd_ring->pages);
+	wd_ring->pages = NULL;
+err_free_head:
+	rtw89_pci_dma_free(pdev, &rtwpci->wd_arena, ring_sz, head, dma);
+	return -ENOMEM;
 }
 
 static int rtw89_pci_alloc_tx_ring(struct rtw89_dev *rtwdev,
@@ -2943,6 +3941,7 @@ static int rtw89_pci_alloc_tx_ring(struct rtw89_dev *rtwdev,
 				   u32 desc_size, u32 len,
 				   enum rtw89_tx_channel txch)
 {
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
 	const struct rtw89_pci_ch_dma_addr *txch_addr;
 	int ring_sz = desc_size * len;
 	u8 *head;
@@ -2961,7 +3960,7 @@ static int rtw89_pci_alloc_tx_ring(struct rtw89_dev *rtwdev,
 		goto err_free_wd_ring;
 	}
 
-	head = dma_alloc_coherent(&pdev->dev, ring_sz, &dma, GFP_KERNEL);
+	head = rtw89_pci_dma_alloc(pdev, &rtwpci->bd_arena, ring_sz, &dma);
 	if (!head) {
 		ret = -ENOMEM;
 		goto err_free_wd_ring;
@@ -2976,6 +3975,8 @@ static int rtw89_pci_alloc_tx_ring(struct rtw89_dev *rtwdev,
 	tx_ring->bd_ring.wp = 0;
 	tx_ring->bd_ring.rp = 0;
 	tx_ring->txch = txch;
+	tx_ring->bd_hwm = 0;
+	tx_ring->wd_hwm = 0;
 
 	return 0;
 
@@ -3001,7 +4002,7 @@ static int rtw89_pci_alloc_tx_rings(struct rtw89_dev *rtwdev,
 			continue;
 		tx_ring = &rtwpci->tx_rings[i];
 		desc_size = sizeof(struct rtw89_pci_tx_bd_32);
-		len = RTW89_PCI_TXBD_NUM_MAX;
+		len = rtwpci->txbd_num;
 		ret = rtw89_pci_alloc_tx_ring(rtwdev, pdev, tx_ring,
 					      desc_size, len, i);
 		if (ret) {
@@ -3015,7 +4016,10 @@ static int rtw89_pci_alloc_tx_rings(struct rtw89_dev *rtwdev,
 err_free:
 	tx_allocated = i;
 	for (i = 0; i < tx_allocated; i++) {
+		if (info->tx_dma_ch_mask & BIT(i))
+			continue;
 		tx_ring = &rtwpci->tx_rings[i];
+		rtw89_pci_free_tx_wd_ring(rtwdev, pdev, tx_ring);
 		rtw89_pci_free_tx_ring(rtwdev, pdev, tx_ring);
 	}
 
@@ -3027,6 +4031,7 @@ static int rtw89_pci_alloc_rx_ring(struct rtw89_dev *rtwdev,
 				   struct rtw89_pci_rx_ring *rx_ring,
 				   u32 desc_size, u32 len, u32 rxch)
 {
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
 	const struct rtw89_pci_ch_dma_addr *rxch_addr;
 	struct sk_buff *skb;
 	u8 *head;
@@ -3042,10 +4047,17 @@ static int rtw89_pci_alloc_rx_ring(struct rtw89_dev *rtwdev,
 		return ret;
 	}
 
-	head = dma_alloc_coherent(&pdev->dev, ring_sz, &dma, GFP_KERNEL);
+	rx_ring->buf = kvcalloc(len, sizeof(*rx_ring->buf), GFP_KERNEL);
+	rx_ring->pages = kvcalloc(len, sizeof(*rx_ring->pages), GFP_KERNEL);
+	if (!rx_ring->buf || !rx_ring->pages) {
+		ret = -ENOMEM;
+		goto err_free_arrays;
+	}
+
+	head = rtw89_pci_dma_alloc(pdev, &rtwpci->bd_arena, ring_sz, &dma);
 	if (!head) {
 		ret = -ENOMEM;
-		goto err;
+		goto err_free_arrays;
 	}
 
 	rx_ring->bd_ring.head = head;
@@ -3058,6 +4070,20 @@ static int rtw89_pci_alloc_rx_ring(struct rtw89_dev *rtwdev,
 	rx_ring->buf_sz = buf_sz;
 	rx_ring->diliver_skb = NULL;
 	rx_ring->diliver_desc.ready = false;
+	rx_ring->page_pool = NULL;
+	rx_ring->rx_copied = 0;
+	rx_ring->rx_zero_copy = 0;
+	rx_ring->bd_hwm = 0;
+
+	if (rxch == RTW89_RXCH_RXQ && !rtw89_pci_disable_rx_zero_copy) {
+		ret = rtw89_pci_alloc_rx_pages(rtwdev, pdev, rx_ring, len);
+		if (!ret)
+			return 0;
+
+		if (ret != -EOPNOTSUPP)
+			rtw89_warn(rtwdev, "failed to alloc rx page pool: %d, fall back to skb\n",
+				   ret);
+	}
 
 	for (i = 0; i < len; i++) {
 		skb = dev_alloc_skb(buf_sz);
@@ -3094,10 +4120,14 @@ err_free:
 
 	head = rx_ring->bd_ring.head;
 	dma = rx_ring->bd_ring.dma;
-	dma_free_coherent(&pdev->dev, ring_sz, head, dma);
+	rtw89_pci_dma_free(pdev, &rtwpci->bd_arena, ring_sz, head, dma);
 
 	rx_ring->bd_ring.head = NULL;
-err:
+err_free_arrays:
+	kvfree(rx_ring->buf);
+	rx_ring->buf = NULL;
+	kvfree(rx_ring->pages);
+	rx_ring->pages = NULL;
 	return ret;
 }
 
@@ -3114,7 +4144,7 @@ static int rtw89_pci_alloc_rx_rings(struct rtw89_dev *rtwdev,
 	for (i = 0; i < RTW89_RXCH_NUM; i++) {
 		rx_ring = &rtwpci->rx_rings[i];
 		desc_size = sizeof(struct rtw89_pci_rx_bd_32);
-		len = RTW89_PCI_RXBD_NUM_MAX;
+		len = rtwpci->rxbd_num;
 		ret = rtw89_pci_alloc_rx_ring(rtwdev, pdev, rx_ring,
 					      desc_size, len, i);
 		if (ret) {
@@ -3138,8 +4168,11 @@ err_free:
 static int rtw89_pci_alloc_trx_rings(struct rtw89_dev *rtwdev,
 				     struct pci_dev *pdev)
 {
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
 	int ret;
 
+	rtw89_pci_alloc_dma_arenas(rtwdev, pdev);
+
 	ret = rtw89_pci_alloc_tx_rings(rtwdev, pdev);
 	if (ret) {
 		rtw89_err(rtwdev, "failed to alloc dma tx rings\n");
@@ -3152,11 +4185,84 @@ static int rtw89_pci_alloc_trx_rings(struct rtw89_dev *rtwdev,
 		goto err_free_tx_rings;
 	}
 
+	rtwpci->rings_allocated = true;
+
 	return 0;
 
 err_free_tx_rings:
 	rtw89_pci_free_tx_rings(rtwdev, pdev);
 err:
+	rtw89_pci_free_dma_arenas(rtwdev, pdev);
+	return ret;
+}
+
+static void rtw89_pci_set_ring_num(struct rtw89_pci *rtwpci, u32 txbd_num,
+				   u32 rxbd_num, u32 txwd_num)
+{
+	rtwpci->txbd_num = clamp_t(u32, txbd_num, RTW89_PCI_TXBD_NUM_MIN,
+				   RTW89_PCI_TXBD_NUM_MAX);
+	rtwpci->rxbd_num = clamp_t(u32, rxbd_num, RTW89_PCI_RXBD_NUM_MIN,
+				   RTW89_PCI_RXBD_NUM_MAX);
+	rtwpci->txwd_num = clamp_t(u32, txwd_num, RTW89_PCI_TXWD_NUM_MIN,
+				   RTW89_PCI_TXWD_NUM_MAX);
+}
+
+/* Reallocate DMA rings with new sizes. Rings are programmed to hardware by
+ * rtw89_pci_ops_reset() on next start, so this is allowed only while down.
+ */
+static int rtw89_pci_ops_resize_rings(struct rtw89_dev *rtwdev, u32 txbd_num,
+				      u32 rxbd_num, u32 txwd_num)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	const struct rtw89_pci_info *info = rtwdev->pci_info;
+	struct pci_dev *pdev = rtwpci->pdev;
+	u32 old_txbd_num = rtwpci->txbd_num;
+	u32 old_rxbd_num = rtwpci->rxbd_num;
+	u32 old_txwd_num = rtwpci->txwd_num;
+	struct rtw89_pci_tx_ring *tx_ring;
+	struct sk_buff_head done;
+	int ret;
+	int i;
+
+	lockdep_assert_held(&rtwdev->mutex);
+
+	if (test_bit(RTW89_FLAG_RUNNING, rtwdev->flags))
+		return -EBUSY;
+
+	/* a previous resize left no rings, just try to allocate them */
+	if (!rtwpci->rings_allocated)
+		goto alloc;
+
+	__skb_queue_head_init(&done);
+	for (i = 0; i < RTW89_TXCH_NUM; i++) {
+		if (info->tx_dma_ch_mask & BIT(i))
+			continue;
+
+		tx_ring = &rtwpci->tx_rings[i];
+		rtw89_pci_tx_ring_lock(tx_ring);
+		if (i == RTW89_TXCH_CH12)
+			rtw89_pci_release_fwcmd(rtwdev, rtwpci,
+						skb_queue_len(&rtwpci->h2c_queue), true);
+		else
+			rtw89_pci_release_tx_ring(rtwdev, tx_ring, &done);
+		rtw89_pci_tx_ring_unlock(tx_ring);
+	}
+	rtw89_pci_tx_status_report(rtwdev, &done);
+
+	rtw89_pci_free_trx_rings(rtwdev, pdev);
+
+alloc:
+	rtw89_pci_set_ring_num(rtwpci, txbd_num, rxbd_num, txwd_num);
+	ret = rtw89_pci_alloc_trx_rings(rtwdev, pdev);
+	if (!ret)
+		return 0;
+
+	rtw89_err(rtwdev, "failed to resize rings, restore previous sizes\n");
+
+	rtw89_pci_set_ring_num(rtwpci, old_txbd_num, old_rxbd_num, old_txwd_num);
+	if (rtw89_pci_alloc_trx_rings(rtwdev, pdev))
+		rtw89_err(rtwdev, "failed to restore rings, device can't start until resized again\n");
+
 	return ret;
 }
 
@@ -3172,6 +4278,7 @@ static int rtw89_pci_setup_resource(struct rtw89_dev *rtwdev,
 {
 	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
 	int ret;
+	int i;
 
 	ret = rtw89_pci_setup_mapping(rtwdev, pdev);
 	if (ret) {
@@ -3179,6 +4286,8 @@ static int rtw89_pci_setup_resource(struct rtw89_dev *rtwdev,
 		goto err;
 	}
 
+	rtw89_pci_set_ring_num(rtwpci, rtw89_pci_txbd_num, rtw89_pci_rxbd_num,
+			       rtw89_pci_txwd_num);
 	ret = rtw89_pci_alloc_trx_rings(rtwdev, pdev);
 	if (ret) {
 		rtw89_err(rtwdev, "failed to alloc pci trx rings\n");
@@ -3188,7 +4297,9 @@ static int rtw89_pci_setup_resource(struct rtw89_dev *rtwdev,
 	rtw89_pci_h2c_init(rtwdev, rtwpci);
 
 	spin_lock_init(&rtwpci->irq_lock);
-	spin_lock_init(&rtwpci->trx_lock);
+	spin_lock_init(&rtwpci->rpq_lock);
+	for (i = 0; i < RTW89_TXCH_NUM; i++)
+		spin_lock_init(&rtwpci->tx_rings[i].lock);
 
 	return 0;
 
@@ -3481,17 +4592,32 @@ static void rtw89_pci_aspm_set(struct rtw89_dev *rtwdev, bool enable)
 
 static void rtw89_pci_recalc_int_mit(struct rtw89_dev *rtwdev)
 {
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
 	struct rtw89_traffic_stats *stats = &rtwdev->stats;
 	enum rtw89_tfc_lv tx_tfc_lv = stats->tx_tfc_lv;
 	enum rtw89_tfc_lv rx_tfc_lv = stats->rx_tfc_lv;
+	struct rtw89_pci_dim *dim = &rtwpci->dim;
+	unsigned long flags;
 	u32 val = 0;
 
+	if (!rtw89_pci_disable_dim) {
+		/* profile is picked by DIM in NAPI poll except for scanning */
+		if (!rtwdev->scanning) {
+			rtw89_pci_dim_apply(rtwdev, rtwpci, dim->dim.profile_ix);
+			return;
+		}
+
+		spin_lock_irqsave(&rtwpci->irq_lock, flags);
+		dim->hw_profile_ix = 0;
+		dim->hw_val = 0;
+		rtw89_write32(rtwdev, R_AX_INT_MIT_RX, 0);
+		spin_unlock_irqrestore(&rtwpci->irq_lock, flags);
+		return;
+	}
+
 	if (!rtwdev->scanning &&
 	    (tx_tfc_lv >= RTW89_TFC_HIGH || rx_tfc_lv >= RTW89_TFC_HIGH))
-		val = B_AX_RXMIT_RXP2_SEL | B_AX_RXMIT_RXP1_SEL |
-		      FIELD_PREP(B_AX_RXCOUNTER_MATCH_MASK, RTW89_PCI_RXBD_NUM_MAX / 2) |
-		      FIELD_PREP(B_AX_RXTIMER_UNIT_MASK, AX_RXTIMER_UNIT_64US) |
-		      FIELD_PREP(B_AX_RXTIMER_MATCH_MASK, 2048 / 64);
+		val = rtw89_pci_int_mit_rx_val(rtwpci->rxbd_num / 2, 2048);
 
 	rtw89_write32(rtwdev, R_AX_INT_MIT_RX, val);
 }
@@ -3528,8 +4654,10 @@ static void rtw89_pci_link_cfg(struct rtw89_dev *rtwdev)
 	if (link_ctrl & PCI_EXP_LNKCTL_CLKREQ_EN)
 		rtw89_pci_clkreq_set(rtwdev, true);
 
-	if (link_ctrl & PCI_EXP_LNKCTL_ASPM_L1)
+	if (link_ctrl & PCI_EXP_LNKCTL_ASPM_L1) {
 		rtw89_pci_aspm_set(rtwdev, true);
+		rtwpci->link_pm.aspm_l1 = !rtw89_pci_disable_aspm_l1;
+	}
 }
 
 static void rtw89_pci_l1ss_set(struct rtw89_dev *rtwdev, bool enable)
@@ -3579,8 +4707,89 @@ static void rtw89_pci_l1ss_cfg(struct rtw89_dev *rtwdev)
 
 	pci_read_config_dword(pdev, l1ss_cap_ptr + PCI_L1SS_CTL1, &l1ss_ctrl);
 
-	if (l1ss_ctrl & PCI_L1SS_CTL1_L1SS_MASK)
+	if (l1ss_ctrl & PCI_L1SS_CTL1_L1SS_MASK) {
 		rtw89_pci_l1ss_set(rtwdev, true);
+		rtwpci->link_pm.l1ss = true;
+	}
+}
+
+static void rtw89_pci_ltr_latency_set(struct rtw89_dev *rtwdev, bool low)
+{
+	const struct rtw89_pci_info *info = rtwdev->pci_info;
+
+	/* report active latency even if idle to keep the link responsive */
+	rtw89_write32(rtwdev, info->ltr_idle_latency_reg,
+		      low ? RTW89_PCI_LTR_ACTIVE_LATENCY :
+			    RTW89_PCI_LTR_IDLE_LATENCY);
+}
+
+static void rtw89_pci_link_pm_set(struct rtw89_dev *rtwdev,
+				  enum rtw89_pci_link_pm_state state)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	struct rtw89_pci_link_pm *link_pm = &rtwpci->link_pm;
+	bool saving = state == RTW89_PCI_LINK_PM_SAVING;
+
+	if (link_pm->state == state)
+		return;
+
+	if (link_pm->aspm_l1)
+		rtw89_pci_aspm_set(rtwdev, saving);
+	if (link_pm->l1ss)
+		rtw89_pci_l1ss_set(rtwdev, saving);
+	if (link_pm->ltr)
+		rtw89_pci_ltr_latency_set(rtwdev, !saving);
+
+	rtw89_debug(rtwdev, RTW89_DBG_HCI, "link pm: %s power saving\n",
+		    saving ? "enter" : "leave");
+
+	link_pm->state = state;
+	link_pm->last_change = jiffies;
+	if (saving)
+		link_pm->to_saving++;
+	else
+		link_pm->to_perf++;
+}
+
+static void rtw89_pci_link_pm_reset(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+
+	rtw89_pci_link_pm_set(rtwdev, RTW89_PCI_LINK_PM_SAVING);
+	rtwpci->link_pm.hold = 0;
+	rtwpci->link_pm.ltr = false;
+}
+
+static void rtw89_pci_recalc_link_pm(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	struct rtw89_pci_link_pm *link_pm = &rtwpci->link_pm;
+	struct rtw89_traffic_stats *stats = &rtwdev->stats;
+	enum rtw89_tfc_lv tfc_lv = max(stats->tx_tfc_lv, stats->rx_tfc_lv);
+	enum rtw89_pci_link_pm_state state = link_pm->state;
+	struct rtw89_pci_tx_ring *tx_ring;
+	u64 lat_pkts = 0;
+	int i;
+
+	for (i = RTW89_TXCH_ACH2; i <= RTW89_TXCH_ACH3; i++) {
+		tx_ring = &rtwpci->tx_rings[i];
+		lat_pkts += tx_ring->tx_mapped + tx_ring->tx_copied;
+	}
+	link_pm->lat_flow = lat_pkts - link_pm->lat_pkts >= RTW89_PCI_LINK_PM_LAT_PKTS;
+	link_pm->lat_pkts = lat_pkts;
+
+	if (rtw89_pci_disable_link_pm) {
+		state = RTW89_PCI_LINK_PM_SAVING;
+		link_pm->hold = 0;
+	} else if (tfc_lv >= RTW89_TFC_HIGH || link_pm->lat_flow) {
+		state = RTW89_PCI_LINK_PM_PERF;
+		link_pm->hold = RTW89_PCI_LINK_PM_HOLD;
+	} else if (tfc_lv <= RTW89_TFC_LOW && link_pm->hold) {
+		if (--link_pm->hold == 0)
+			state = RTW89_PCI_LINK_PM_SAVING;
+	}
+
+	rtw89_pci_link_pm_set(rtwdev, state);
 }
 
 static int rtw89_pci_poll_io_idle(struct rtw89_dev *rtwdev)
@@ -3701,28 +4910,58 @@ static void rtw89_pci_ops_dump_err_status(struct rtw89_dev *rtwdev)
 		   rtw89_read32(rtwdev, R_AX_LBC_WATCHDOG));
 }
 
+static void rtw89_pci_napi_complete(struct rtw89_dev *rtwdev,
+				    struct rtw89_pci *rtwpci, u8 napi_bit)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&rtwpci->irq_lock, flags);
+	rtwpci->napi_pending &= ~napi_bit;
+	if (likely(rtwpci->running) && !rtwpci->napi_pending)
+		rtw89_chip_enable_intr(rtwdev, rtwpci);
+	spin_unlock_irqrestore(&rtwpci->irq_lock, flags);
+}
+
 static int rtw89_pci_napi_poll(struct napi_struct *napi, int budget)
 {
 	struct rtw89_dev *rtwdev = container_of(napi, struct rtw89_dev, napi);
 	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
-	unsigned long flags;
+	bool by_irq = true;
 	int work_done;
 
 	rtwdev->napi_budget_countdown = budget;
 
-	rtw89_pci_clear_isr0(rtwdev, B_AX_RPQDMA_INT | B_AX_RPQBD_FULL_INT);
-	work_done = rtw89_pci_poll_rpq_dma(rtwdev, rtwpci, rtwdev->napi_budget_countdown);
-	if (work_done == budget)
-		return budget;
+	/* a poll kicked only by the PPDU status flush timer isn't an interrupt
+	 * event, so keep it out of IRQ latency and DIM accounting
+	 */
+	if (READ_ONCE(rtwdev->ppdu_sts.napi_by_timer)) {
+		WRITE_ONCE(rtwdev->ppdu_sts.napi_by_timer, false);
+		by_irq = READ_ONCE(rtwpci->napi_pending) & RTW89_PCI_NAPI_RX;
+	}
 
+	if (by_irq)
+		rtw89_pci_irq_lat_record(&rtwpci->irq_lat.rx);
 	rtw89_pci_clear_isr0(rtwdev, B_AX_RXP1DMA_INT | B_AX_RXDMA_INT | B_AX_RDU_INT);
-	work_done += rtw89_pci_poll_rxq_dma(rtwdev, rtwpci, rtwdev->napi_budget_countdown);
-	if (work_done < budget && napi_complete_done(napi, work_done)) {
-		spin_lock_irqsave(&rtwpci->irq_lock, flags);
-		if (likely(rtwpci->running))
-			rtw89_chip_enable_intr(rtwdev, rtwpci);
-		spin_unlock_irqrestore(&rtwpci->irq_lock, flags);
-	}
+	work_done = rtw89_pci_poll_rxq_dma(rtwdev, rtwpci, budget);
+	if (by_irq)
+		rtw89_pci_dim_update(rtwdev, rtwpci);
+	if (work_done < budget && napi_complete_done(napi, work_done))
+		rtw89_pci_napi_complete(rtwdev, rtwpci, RTW89_PCI_NAPI_RX);
+
+	return work_done;
+}
+
+static int rtw89_pci_napi_poll_tx(struct napi_struct *napi, int budget)
+{
+	struct rtw89_dev *rtwdev = container_of(napi, struct rtw89_dev, napi_tx);
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	int work_done;
+
+	rtw89_pci_irq_lat_record(&rtwpci->irq_lat.tx);
+	rtw89_pci_clear_isr0(rtwdev, B_AX_RPQDMA_INT | B_AX_RPQBD_FULL_INT);
+	work_done = rtw89_pci_poll_rpq_dma(rtwdev, rtwpci, budget);
+	if (work_done < budget && napi_complete_done(napi, work_done))
+		rtw89_pci_napi_complete(rtwdev, rtwpci, RTW89_PCI_NAPI_TX);
 
 	return work_done;
 }
@@ -3783,6 +5022,7 @@ static int __maybe_unused rtw89_pci_resume(struct device *dev)
 	}
 	rtw89_pci_l2_hci_ldo(rtwdev);
 	rtw89_pci_filter_out(rtwdev);
+	rtw89_pci_link_pm_set(rtwdev, RTW89_PCI_LINK_PM_SAVING);
 	rtw89_pci_link_cfg(rtwdev);
 	rtw89_pci_l1ss_cfg(rtwdev);
 
@@ -3802,6 +5042,7 @@ static const struct rtw89_hci_ops rtw89_pci_ops = {
 	.pause		= rtw89_pci_ops_pause,
 	.switch_mode	= rtw89_pci_ops_switch_mode,
 	.recalc_int_mit = rtw89_pci_recalc_int_mit,
+	.recalc_link_pm = rtw89_pci_recalc_link_pm,
 
 	.read8		= rtw89_pci_ops_read8,
 	.read16		= rtw89_pci_ops_read16,
@@ -3818,6 +5059,7 @@ static const struct rtw89_hci_ops rtw89_pci_ops = {
 	.mac_lv1_rcvy	= rtw89_pci_ops_mac_lv1_recovery,
 	.dump_err_status = rtw89_pci_ops_dump_err_status,
 	.napi_poll	= rtw89_pci_napi_poll,
+	.napi_poll_tx	= rtw89_pci_napi_poll_tx,
 
 	.recovery_start = rtw89_pci_ops_recovery_start,
 	.recovery_complete = rtw89_pci_ops_recovery_complete,
@@ -3831,6 +5073,7 @@ static const struct rtw89_hci_ops rtw89_pci_ops = {
 	.disable_intr	= rtw89_pci_disable_intr_lock,
 	.enable_intr	= rtw89_pci_enable_intr_lock,
 	.rst_bdram	= rtw89_pci_rst_bdram_pcie,
+	.resize_rings	= rtw89_pci_ops_resize_rings,
 };
 
 int rtw89_pci_probe(struct pci_dev *pdev, const struct pci_device_id *id)
@@ -3858,6 +5101,10 @@ int rtw89_pci_probe(struct pci_dev *pdev, const struct pci_device_id *id)
 	rtwdev->hci.rpwm_addr = pci_info->rpwm_addr;
 	rtwdev->hci.cpwm_addr = pci_info->cpwm_addr;
 
+	/* fragments of skb are mapped to address info of TX WD */
+	if (!rtw89_pci_disable_tx_sg)
+		rtwdev->hw->netdev_features |= NETIF_F_SG;
+
 	SET_IEEE80211_DEV(rtwdev->hw, &pdev->dev);
 
 	ret = rtw89_core_init(rtwdev);
@@ -3889,6 +5136,10 @@ int rtw89_pci_probe(struct pci_dev *pdev, const struct pci_device_id *id)
 	rtw89_pci_l1ss_cfg(rtwdev);
 
 	rtw89_core_napi_init(rtwdev);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 12, 0)
+	if (rtw89_pci_threaded_napi && dev_set_threaded(&rtwdev->netdev, true))
+		rtw89_warn(rtwdev, "failed to enable threaded NAPI\n");
+#endif
 
 	ret = rtw89_pci_request_irq(rtwdev, pdev);
 	if (ret) {
@@ -5,6 +5,8 @@
 #ifndef __RTW89_PCI_H__
 #define __RTW89_PCI_H__
 
+#include <linux/dim.h>
+
 #include "txrx.h"
 
 #define MDIO_PG0_G1 0
@@ -554,12 +556,37 @@
 #define R_AX_PCIE_HRPWM_V1		0x30C0
 #define R_AX_PCIE_CRPWM			0x30C4
 
-#define RTW89_PCI_TXBD_NUM_MAX		256
-#define RTW89_PCI_RXBD_NUM_MAX		256
-#define RTW89_PCI_TXWD_NUM_MAX		512
+#define RTW89_PCI_LTR_ACTIVE_LATENCY	0x880b880b
+#define RTW89_PCI_LTR_IDLE_LATENCY	0x90039003
+
+#define RTW89_PCI_TXBD_NUM_DEF		256
+#define RTW89_PCI_RXBD_NUM_DEF		256
+#define RTW89_PCI_TXWD_NUM_DEF		512
+/* ring sizes can be set by module parameters or debugfs within hardware
+ * limits: 12-bit BD index (TXBD_HOST_IDX_MASK) and 15-bit WD sequence
+ * (RTW89_PCI_RPP_SEQ)
+ */
+#define RTW89_PCI_TXBD_NUM_MAX		4095
+#define RTW89_PCI_RXBD_NUM_MAX		4095
+#define RTW89_PCI_TXWD_NUM_MAX		0x7fff
+#define RTW89_PCI_TXBD_NUM_MIN		32
+#define RTW89_PCI_RXBD_NUM_MIN		32
+#define RTW89_PCI_TXWD_NUM_MIN		32
+/* rings carved from DMA arenas start at multiples of cache line size */
+#define RTW89_PCI_DMA_ARENA_ALIGN	256
 #define RTW89_PCI_TXWD_PAGE_SIZE	128
+/* pre-mapped buffer following a WD page for copybreak of small frames */
+#define RTW89_PCI_TX_COPYBREAK_MAX	256
 #define RTW89_PCI_ADDRINFO_MAX		4
+/* DMA segments of a TX frame, i.e. linear data and its page fragments */
+#define RTW89_PCI_TX_SEG_MAX		RTW89_TXADDR_INFO_NR_V1
+#define RTW89_PCI_TX_FRAG_MAX		(RTW89_PCI_TX_SEG_MAX - 1)
 #define RTW89_PCI_RX_BUF_SIZE		11460
+#define RTW89_PCI_RX_PP_HEADROOM	NET_SKB_PAD
+#define RTW89_PCI_RX_PP_TRUESIZE	(SKB_DATA_ALIGN(RTW89_PCI_RX_PP_HEADROOM + \
+							RTW89_PCI_RX_BUF_SIZE) + \
+					 SKB_DATA_ALIGN(sizeof(struct skb_shared_info)))
+#define RTW89_PCI_RX_PP_ORDER		get_order(RTW89_PCI_RX_PP_TRUESIZE)
 
 #define RTW89_PCI_POLL_BDRAM_RST_CNT	100
 #define RTW89_PCI_MULTITAG		8
@@ -732,6 +759,7 @@ enum rtw89_pci_intr_mask_cfg {
 
 struct rtw89_pci_isrs;
 struct rtw89_pci;
+struct page_pool;
 
 struct rtw89_pci_bd_idx_addr {
 	u32 tx_bd_addrs[RTW89_TXCH_NUM];
@@ -786,18 +814,21 @@ struct rtw89_pci_info {
 	struct rtw89_reg_def dma_busy1;
 	u32 dma_busy2_reg;
 	u32 dma_busy3_reg;
+	u32 ltr_idle_latency_reg;
 
 	u32 rpwm_addr;
 	u32 cpwm_addr;
 	u32 tx_dma_ch_mask;
+	u8 txaddr_info_nr_max;
 	const struct rtw89_pci_bd_idx_addr *bd_idx_addr_low_power;
 	const struct rtw89_pci_ch_dma_addr_set *dma_addr_set;
 	const struct rtw89_pci_bd_ram (*bd_ram_table)[RTW89_TXCH_NUM];
 
 	int (*ltr_set)(struct rtw89_dev *rtwdev, bool en);
 	u32 (*fill_txaddr_info)(struct rtw89_dev *rtwdev,
-				void *txaddr_info_addr, u32 total_len,
-				dma_addr_t dma, u8 *add_info_nr);
+				void *txaddr_info_addr,
+				const struct rtw89_pci_tx_seg *segs, u8 seg_num,
+				u8 *add_info_nr);
 	void (*config_intr_mask)(struct rtw89_dev *rtwdev);
 	void (*enable_intr)(struct rtw89_dev *rtwdev, struct rtw89_pci *rtwpci);
 	void (*disable_intr)(struct rtw89_dev *rtwdev, struct rtw89_pci *rtwpci);
@@ -843,6 +874,11 @@ struct rtw89_pci_tx_addr_info_32 {
 	__le32 dma;
 } __packed;
 
+struct rtw89_pci_tx_seg {
+	dma_addr_t dma;
+	u32 len;
+};
+
 #define RTW89_TXADDR_INFO_NR_V1		10
 
 struct rtw89_pci_tx_addr_info_32_v1 {
@@ -892,6 +928,10 @@ struct rtw89_pci_tx_wd {
 	dma_addr_t paddr;
 	u32 len;
 	u32 seq;
+	/* skb is copied to copybreak buffer instead of being mapped */
+	bool copied;
+	/* number of page fragments mapped into frag_dma of wd_ring */
+	u8 nr_frags;
 };
 
 struct rtw89_pci_dma_ring {
@@ -906,21 +946,42 @@ struct rtw89_pci_dma_ring {
 	u32 rp; /* hw idx */
 };
 
+struct rtw89_pci_dma_arena {
+	void *head;
+	dma_addr_t dma;
+	u32 size;
+	/* end of the last carved ring */
+	u32 offset;
+};
+
 struct rtw89_pci_tx_wd_ring {
 	void *head;
 	dma_addr_t dma;
 
-	struct rtw89_pci_tx_wd pages[RTW89_PCI_TXWD_NUM_MAX];
+	/* page_num entries */
+	struct rtw89_pci_tx_wd *pages;
 	struct list_head free_pages;
 
 	u32 page_size;
 	u32 page_num;
 	u32 curr_num;
+	/* frames not longer than this are copied, 0 if disabled */
+	u32 copybreak;
+	/* DMA addresses of page fragments, RTW89_PCI_TX_FRAG_MAX per page */
+	dma_addr_t *frag_dma;
 };
 
 #define RTW89_RX_TAG_MAX		0x1fff
 
+struct rtw89_pci_lock_stats {
+	u64 acquired;
+	u64 contended;
+};
+
 struct rtw89_pci_tx_ring {
+	/* protect BD, WD and pending skbs of this ring */
+	spinlock_t lock;
+	struct rtw89_pci_lock_stats lock_stats;
 	struct rtw89_pci_tx_wd_ring wd_ring;
 	struct rtw89_pci_dma_ring bd_ring;
 	struct list_head busy_pages;
@@ -929,18 +990,90 @@ struct rtw89_pci_tx_ring {
 	u16 tag; /* range from 0x0001 ~ 0x1fff */
 
 	u64 tx_cnt;
+	u64 tx_mapped;
+	u64 tx_copied;
+	u64 tx_sg;
+	u64 tx_linearized;
+	/* high-watermarks of BDs pending in hardware and WDs in flight */
+	u32 bd_hwm;
+	u32 wd_hwm;
 	u64 tx_acked;
 	u64 tx_retry_lmt;
 	u64 tx_life_time;
 	u64 tx_mac_id_drop;
 };
 
+struct rtw89_pci_rx_page {
+	struct page *page;
+	dma_addr_t dma;
+};
+
 struct rtw89_pci_rx_ring {
 	struct rtw89_pci_dma_ring bd_ring;
-	struct sk_buff *buf[RTW89_PCI_RXBD_NUM_MAX];
+	/* bd_ring.len entries */
+	struct sk_buff **buf;
+	/* RX buffers are pages of page_pool instead of skbs if it's set */
+	struct page_pool *page_pool;
+	struct rtw89_pci_rx_page *pages;
 	u32 buf_sz;
 	struct sk_buff *diliver_skb;
 	struct rtw89_rx_desc_info diliver_desc;
+
+	u64 rx_copied;
+	u64 rx_zero_copy;
+	u64 rx_bytes;
+	/* high-watermark of filled BDs found by a poll */
+	u32 bd_hwm;
+};
+
+#define RTW89_PCI_NAPI_RX		BIT(0)
+#define RTW89_PCI_NAPI_TX		BIT(1)
+
+#define RTW89_PCI_DIM_PROFILE_NUM	NET_DIM_PARAMS_NUM_PROFILES
+
+/* Dynamic interrupt moderation of RX. Samples are taken in NAPI poll and
+ * fed to net_dim(), whose profile index selects INT_MIT_RX settings.
+ */
+struct rtw89_pci_dim {
+	struct dim dim;
+	u16 events;
+
+	/* protected by irq_lock */
+	u8 hw_profile_ix;
+	u32 hw_val;
+	u32 transitions;
+
+	u32 profile_polls[RTW89_PCI_DIM_PROFILE_NUM];
+};
+
+/* track periods of low traffic to wait before saving power again */
+#define RTW89_PCI_LINK_PM_HOLD		3
+/* VI/VO frames sent in a track period to be seen as a low latency flow */
+#define RTW89_PCI_LINK_PM_LAT_PKTS	20
+
+enum rtw89_pci_link_pm_state {
+	RTW89_PCI_LINK_PM_SAVING,
+	RTW89_PCI_LINK_PM_PERF,
+};
+
+/* ASPM L1/L1SS and LTR are turned off on high traffic or low latency flows,
+ * and turned on again after RTW89_PCI_LINK_PM_HOLD periods of low traffic.
+ * Traffic level in between keeps the current state.
+ */
+struct rtw89_pci_link_pm {
+	/* features enabled at probe/power on that can be switched */
+	bool aspm_l1;
+	bool l1ss;
+	bool ltr;
+
+	enum rtw89_pci_link_pm_state state;
+	u8 hold;
+	bool lat_flow;
+	u64 lat_pkts;
+
+	unsigned long last_change;
+	u32 to_perf;
+	u32 to_saving;
 };
 
 struct rtw89_pci_isrs {
@@ -949,21 +1082,66 @@ struct rtw89_pci_isrs {
 	u32 isrs[2];
 };
 
+/* bucket n counts latencies in [2^(n-1), 2^n) us, the last one is open */
+#define RTW89_PCI_IRQ_LAT_HIST_NUM	12
+
+enum rtw89_pci_irq_path {
+	RTW89_PCI_IRQ_PATH_HARDIRQ,
+	RTW89_PCI_IRQ_PATH_THREAD,
+
+	RTW89_PCI_IRQ_PATH_NUM,
+};
+
+struct rtw89_pci_irq_lat_napi {
+	/* time of the hard IRQ that scheduled the NAPI, 0 if not scheduled */
+	u64 sched_ns;
+	u8 path;
+	/* only updated by poll of the NAPI, which may run on another CPU
+	 * than the other one
+	 */
+	u32 hist[RTW89_PCI_IRQ_PATH_NUM][RTW89_PCI_IRQ_LAT_HIST_NUM];
+};
+
+/* Latency from hard IRQ to the first poll of the NAPI it scheduled. */
+struct rtw89_pci_irq_lat {
+	u64 hardirq_ns;
+	struct rtw89_pci_irq_lat_napi rx;
+	struct rtw89_pci_irq_lat_napi tx;
+	u64 irqs[RTW89_PCI_IRQ_PATH_NUM];
+};
+
 struct rtw89_pci {
 	struct pci_dev *pdev;
 
 	/* protect HW irq related registers */
 	spinlock_t irq_lock;
-	/* protect TRX resources (exclude RXQ) */
-	spinlock_t trx_lock;
+	/* protect RPQ, and it's taken before the lock of TX rings */
+	spinlock_t rpq_lock;
+	struct rtw89_pci_lock_stats rpq_lock_stats;
 	bool running;
 	bool low_power;
 	bool under_recovery;
 	struct rtw89_pci_tx_ring tx_rings[RTW89_TXCH_NUM];
 	struct rtw89_pci_rx_ring rx_rings[RTW89_RXCH_NUM];
+	u32 txbd_num;
+	u32 rxbd_num;
+	u32 txwd_num;
+	/* cleared if rings can't be allocated again after resizing */
+	bool rings_allocated;
+	struct rtw89_pci_dma_arena bd_arena;
+	struct rtw89_pci_dma_arena wd_arena;
 	struct sk_buff_head h2c_queue;
 	struct sk_buff_head h2c_release_queue;
 	DECLARE_BITMAP(kick_map, RTW89_TXCH_NUM);
+	struct rtw89_pci_dim dim;
+	struct rtw89_pci_link_pm link_pm;
+	/* NAPIs to complete before enabling interrupts, protected by irq_lock */
+	u8 napi_pending;
+	/* recognized by hard IRQ handler for the thread, protected by irq_lock */
+	struct rtw89_pci_isrs thread_isrs;
+	struct rtw89_pci_irq_lat irq_lat;
+	u64 tx_status_batches;
+	u64 tx_status_reported;
 
 	u32 ind_intrs;
 	u32 halt_c2h_intrs;
@@ -971,6 +1149,30 @@ struct rtw89_pci {
 	void __iomem *mmap;
 };
 
+/* Registers of BD index and interrupts are out of CMAC, so the hot path
+ * accesses them by MMIO directly instead of indirect calls of HCI ops.
+ */
+static inline u32 rtw89_pci_dp_read32(struct rtw89_dev *rtwdev, u32 addr)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+
+	return readl(rtwpci->mmap + addr);
+}
+
+static inline void rtw89_pci_dp_write16(struct rtw89_dev *rtwdev, u32 addr, u16 data)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+
+	writew(data, rtwpci->mmap + addr);
+}
+
+static inline void rtw89_pci_dp_write32(struct rtw89_dev *rtwdev, u32 addr, u32 data)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+
+	writel(data, rtwpci->mmap + addr);
+}
+
 static inline struct rtw89_pci_rx_info *RTW89_PCI_RX_SKB_CB(struct sk_buff *skb)
 {
 	struct ieee80211_tx_info *info = IEEE80211_SKB_CB(skb);
@@ -1069,11 +1271,13 @@ void rtw89_pci_remove(struct pci_dev *pdev);
 int rtw89_pci_ltr_set(struct rtw89_dev *rtwdev, bool en);
 int rtw89_pci_ltr_set_v1(struct rtw89_dev *rtwdev, bool en);
 u32 rtw89_pci_fill_txaddr_info(struct rtw89_dev *rtwdev,
-			       void *txaddr_info_addr, u32 total_len,
-			       dma_addr_t dma, u8 *add_info_nr);
+			       void *txaddr_info_addr,
+			       const struct rtw89_pci_tx_seg *segs, u8 seg_num,
+			       u8 *add_info_nr);
 u32 rtw89_pci_fill_txaddr_info_v1(struct rtw89_dev *rtwdev,
-				  void *txaddr_info_addr, u32 total_len,
-				  dma_addr_t dma, u8 *add_info_nr);
+				  void *txaddr_info_addr,
+				  const struct rtw89_pci_tx_seg *segs, u8 seg_num,
+				  u8 *add_info_nr);
 void rtw89_pci_config_intr_mask(struct rtw89_dev *rtwdev);
 void rtw89_pci_config_intr_mask_v1(struct rtw89_dev *rtwdev);
 void rtw89_pci_enable_intr(struct rtw89_dev *rtwdev, struct rtw89_pci *rtwpci);
@@ -1089,13 +1293,17 @@ void rtw89_pci_recognize_intrs_v1(struct rtw89_dev *rtwdev,
 
 static inline
 u32 rtw89_chip_fill_txaddr_info(struct rtw89_dev *rtwdev,
-				void *txaddr_info_addr, u32 total_len,
-				dma_addr_t dma, u8 *add_info_nr)
+				void *txaddr_info_addr,
+				const struct rtw89_pci_tx_seg *segs, u8 seg_num,
+				u8 *add_info_nr)
 {
 	const struct rtw89_pci_info *info = rtwdev->pci_info;
 
-	return info->fill_txaddr_info(rtwdev, txaddr_info_addr, total_len,
-				      dma, add_info_nr);
+	return INDIRECT_CALL_2(info->fill_txaddr_info,
+			       rtw89_pci_fill_txaddr_info,
+			       rtw89_pci_fill_txaddr_info_v1,
+			       rtwdev, txaddr_info_addr, segs, seg_num,
+			       add_info_nr);
 }
 
 static inline void rtw89_chip_config_intr_mask(struct rtw89_dev *rtwdev,
@@ -1136,7 +1344,9 @@ void rtw89_chip_enable_intr(struct rtw89_dev *rtwdev, struct rtw89_pci *rtwpci)
 {
 	const struct rtw89_pci_info *info = rtwdev->pci_info;
 
-	info->enable_intr(rtwdev, rtwpci);
+	INDIRECT_CALL_2(info->enable_intr,
+			rtw89_pci_enable_intr, rtw89_pci_enable_intr_v1,
+			rtwdev, rtwpci);
 }
 
 static inline
@@ -1144,7 +1354,9 @@ void rtw89_chip_disable_intr(struct rtw89_dev *rtwdev, struct rtw89_pci *rtwpci)
 {
 	const struct rtw89_pci_info *info = rtwdev->pci_info;
 
-	info->disable_intr(rtwdev, rtwpci);
+	INDIRECT_CALL_2(info->disable_intr,
+			rtw89_pci_disable_intr, rtw89_pci_disable_intr_v1,
+			rtwdev, rtwpci);
 }
 
 static inline
@@ -1154,7 +1366,9 @@ void rtw89_chip_recognize_intrs(struct rtw89_dev *rtwdev,
 {
 	const struct rtw89_pci_info *info = rtwdev->pci_info;
 
-	info->recognize_intrs(rtwdev, rtwpci, isrs);
+	INDIRECT_CALL_2(info->recognize_intrs,
+			rtw89_pci_recognize_intrs, rtw89_pci_recognize_intrs_v1,
+			rtwdev, rtwpci, isrs);
 }
 
 #endif
@@ -34,7 +34,7 @@ static void rtw89_ps_power_mode_change_with_hci(struct rtw89_dev *rtwdev,
 {
 	ieee80211_stop_queues(rtwdev->hw);
 	rtwdev->hci.paused = true;
-	flush_work(&rtwdev->txq_work);
+	rtw89_core_txq_sched_flush(rtwdev);
 	ieee80211_wake_queues(rtwdev->hw);
 
 	rtw89_hci_pause(rtwdev, true);
@@ -46,7 +46,7 @@ static void rtw89_ps_power_mode_change_with_hci(struct rtw89_dev *rtwdev,
 
 	if (!enter) {
 		local_bh_disable();
-		napi_schedule(&rtwdev->napi);
+		rtw89_core_napi_schedule(rtwdev);
 		local_bh_enable();
 	}
 }
@@ -122,6 +122,8 @@ void rtw89_enter_lps(struct rtw89_dev *rtwdev, struct rtw89_vif *rtwvif,
 	if (test_and_set_bit(RTW89_FLAG_LEISURE_PS, rtwdev->flags))
 		return;
 
+	rtw89_core_tx_desc_tmpl_invalidate(rtwdev);
+
 	__rtw89_enter_lps(rtwdev, rtwvif->mac_id);
 	if (ps_mode)
 		__rtw89_enter_ps_mode(rtwdev, rtwvif);
@@ -145,6 +147,8 @@ void rtw89_leave_lps(struct rtw89_dev *rtwdev)
 	if (!test_and_clear_bit(RTW89_FLAG_LEISURE_PS, rtwdev->flags))
 		return;
 
+	rtw89_core_tx_desc_tmpl_invalidate(rtwdev);
+
 	__rtw89_leave_ps_mode(rtwdev);
 
 	rtw89_for_each_rtwvif(rtwdev, rtwvif)
@@ -38,10 +38,12 @@ static const struct rtw89_pci_info rtw8852a_pci_info = {
 	.dma_busy1		= {R_AX_PCIE_DMA_BUSY1, DMA_BUSY1_CHECK},
 	.dma_busy2_reg		= R_AX_PCIE_DMA_BUSY2,
 	.dma_busy3_reg		= R_AX_PCIE_DMA_BUSY1,
+	.ltr_idle_latency_reg	= R_AX_LTR_IDLE_LATENCY,
 
 	.rpwm_addr		= R_AX_PCIE_HRPWM,
 	.cpwm_addr		= R_AX_CPWM,
 	.tx_dma_ch_mask		= 0,
+	.txaddr_info_nr_max	= RTW89_PCI_ADDRINFO_MAX,
 	.bd_idx_addr_low_power	= NULL,
 	.dma_addr_set		= &rtw89_pci_ch_dma_addr_set,
 	.bd_ram_table		= &rtw89_bd_ram_table_dual,
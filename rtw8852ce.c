@@ -47,10 +47,12 @@ static const struct rtw89_pci_info rtw8852c_pci_info = {
 	.dma_busy1		= {R_AX_HAXI_DMA_BUSY1, DMA_BUSY1_CHECK},
 	.dma_busy2_reg		= R_AX_HAXI_DMA_BUSY2,
 	.dma_busy3_reg		= R_AX_HAXI_DMA_BUSY3,
+	.ltr_idle_latency_reg	= R_AX_LTR_LATENCY_IDX3,
 
 	.rpwm_addr		= R_AX_PCIE_HRPWM_V1,
 	.cpwm_addr		= R_AX_PCIE_CRPWM,
 	.tx_dma_ch_mask		= 0,
+	.txaddr_info_nr_max	= RTW89_TXADDR_INFO_NR_V1,
 	.bd_idx_addr_low_power	= &rtw8852c_bd_idx_addr_low_power,
 	.dma_addr_set		= &rtw89_pci_ch_dma_addr_set_v1,
 	.bd_ram_table		= &rtw89_bd_ram_table_dual,
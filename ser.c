@@ -333,12 +333,20 @@ static void ser_deinit_cam(struct rtw89_dev *rtwdev, struct rtw89_vif *rtwvif)
 static void ser_reset_mac_binding(struct rtw89_dev *rtwdev)
 {
 	struct rtw89_vif *rtwvif;
+	int i;
 
 	rtw89_cam_reset_keys(rtwdev);
 	rtw89_for_each_rtwvif(rtwdev, rtwvif)
 		ser_deinit_cam(rtwdev, rtwvif);
 
 	rtw89_core_release_all_bits_map(rtwdev->mac_id_map, RTW89_MAX_MAC_ID_NUM);
+	/* stations can get other mac_id after restart, so drop old lookups */
+	for (i = 0; i < RTW89_MAX_MAC_ID_NUM; i++)
+		RCU_INIT_POINTER(rtwdev->sta_on_mac_id[i], NULL);
+	/* and vifs can be added back on other ports */
+	for (i = 0; i < RTW89_PORT_NUM; i++)
+		RCU_INIT_POINTER(rtwdev->vif_on_port[i], NULL);
+	synchronize_rcu();
 	rtw89_for_each_rtwvif(rtwdev, rtwvif)
 		ser_reset_vif(rtwdev, rtwvif);
 
@@ -458,6 +466,7 @@ static void ser_reset_trx_st_hdl(struct rtw89_ser *ser, u8 evt)
 	switch (evt) {
 	case SER_EV_STATE_IN:
 		cancel_delayed_work_sync(&rtwdev->track_work);
+		cancel_delayed_work_sync(&rtwdev->dm_work);
 		drv_stop_tx(ser);
 
 		if (hal_stop_dma(ser)) {